@@ -1,8 +1,36 @@
+/* POSIX and Linux interfaces (clock_gettime, pread, mkdtemp, madvise,
+   O_CLOEXEC, ...) are used throughout; expose them under any -std */
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
 #include <strings.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 /* ============================================================================
    DEFINITIONS & CONSTANTS
@@ -10,6 +38,18 @@
 
 #define EMP_FILE "employees.txt"
 #define CUST_FILE "customers.txt"
+#define CUST_JOURNAL "customers.journal"
+#define EMP_BIN "employees.bin"
+#define CUST_BIN "customers.bin"
+#define LOCK_FILE "banking.lock"
+#define META_FILE "banking.meta"
+#define EMP_TOMBSTONES "employees.deleted"
+
+/* Fold the journal into a fresh customers.txt after this many postings */
+#define JOURNAL_CHECKPOINT_EVERY 10000
+/* Rewrite a text table once deleted records pending removal from its file
+   exceed this percentage of the live ones */
+#define COMPACT_DEAD_PERCENT 25
 
 #define MAX_LINE 1024
 #define MAX_NAME 100
@@ -18,6 +58,10 @@
 #define MAX_AAD 14
 #define MAX_PHONE 12
 
+#define MIN_BALANCE 1000
+#define MIN_DEPOSIT 1000
+#define MAX_DEPOSIT 50000
+
 /* ============================================================================
    STRUCTURES
    ============================================================================ */
@@ -38,6 +82,205 @@ typedef struct {
     char address[MAX_ADDR];
 } Customer;
 
+/* In memory, customers are held split by access pattern (see CUSTOMER
+   TABLE); Customer is only the materialized form used at the edges. */
+typedef struct {
+    int account;
+    uint32_t cold;          /* index into CustTable.cold */
+    long balance;
+} CustHot;
+
+typedef enum { CF_NAME, CF_AADHAAR, CF_PHONE, CF_ADDRESS, CF_COUNT } CustField;
+
+typedef struct {
+    uint32_t off[CF_COUNT];     /* arena offset of each text field */
+} CustCold;
+
+typedef struct {
+    char *data;
+    size_t len, cap;
+} StrArena;
+
+typedef struct {
+    CustHot *hot;           /* one per customer, in file order */
+    int count, cap;
+    CustCold *cold;         /* append-only; entries of dropped records linger */
+    uint32_t cold_count, cold_cap;
+    StrArena arena;
+    size_t garbage;         /* arena bytes no live record refers to */
+} CustTable;
+
+/* ============================================================================
+   METRICS
+   ============================================================================ */
+
+/* Every menu operation and storage call records its latency in a histogram
+   of its own, with an op count and the bytes it read or wrote. Histograms
+   are log-linear (HDR style): 16 sub-buckets per power of two nanoseconds,
+   so a reported percentile is within 1/16 of the true value. Recording is
+   a handful of relaxed atomic adds and is safe from any thread. Menu
+   operations exclude the time spent waiting for terminal input. */
+#define METRIC_SUB_BITS 4
+#define METRIC_SUB (1 << METRIC_SUB_BITS)
+#define METRIC_BUCKETS (64 * METRIC_SUB)
+#define STATS_FILE "banking.stats"
+
+typedef enum {
+    M_MENU_CREATE, M_MENU_SEARCH, M_MENU_DELETE, M_MENU_UPDATE,
+    M_MENU_VIEW, M_MENU_EXPORT, M_MENU_WITHDRAW, M_MENU_DEPOSIT,
+    M_POST, M_FLUSH,
+    M_LOAD_EMPLOYEES, M_LOAD_CUSTOMERS, M_SAVE_EMPLOYEES, M_SAVE_CUSTOMERS,
+    M_APPEND_EMPLOYEE, M_APPEND_CUSTOMER, M_APPEND_TOMBSTONE,
+    M_JOURNAL_READ, M_JOURNAL_COMMIT, M_META_SAVE, M_BIN_LOAD, M_BIN_SYNC,
+    M_SERVER_REQUEST, M_COL_WRITE, M_COL_READ,
+    M_COUNT
+} MetricOp;
+
+static const char *const metric_names[M_COUNT] = {
+    "menu_create", "menu_search", "menu_delete", "menu_update",
+    "menu_view", "menu_export", "menu_withdraw", "menu_deposit",
+    "post", "flush",
+    "load_employees", "load_customers", "save_employees", "save_customers",
+    "append_employee", "append_customer", "append_tombstone",
+    "journal_read", "journal_commit", "meta_save", "bin_load", "bin_sync",
+    "server_request", "col_write", "col_read"
+};
+
+typedef struct {
+    uint64_t count, total_ns, max_ns;
+    uint64_t bytes_read, bytes_written;
+    uint64_t buckets[METRIC_BUCKETS];
+} Metric;
+
+static Metric metrics[M_COUNT];
+static uint64_t metric_input_ns;    /* main thread: time blocked in read_line_input */
+
+static uint64_t metric_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+static int metric_bucket(uint64_t ns) {
+    if (ns < METRIC_SUB) return (int)ns;
+    int e = 63 - __builtin_clzll(ns);
+    return (e - METRIC_SUB_BITS + 1) * METRIC_SUB + (int)((ns >> (e - METRIC_SUB_BITS)) & (METRIC_SUB - 1));
+}
+
+/* Largest value that falls into bucket b */
+static uint64_t metric_bucket_high(int b) {
+    if (b < METRIC_SUB) return (uint64_t)b;
+    int e = b / METRIC_SUB + METRIC_SUB_BITS - 1, m = b % METRIC_SUB;
+    return ((uint64_t)(METRIC_SUB + m + 1) << (e - METRIC_SUB_BITS)) - 1;
+}
+
+static void metric_record_ns(MetricOp op, uint64_t ns, uint64_t bytes_read, uint64_t bytes_written) {
+    Metric *m = &metrics[op];
+    __atomic_fetch_add(&m->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->total_ns, ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->buckets[metric_bucket(ns)], 1, __ATOMIC_RELAXED);
+    if (bytes_read) __atomic_fetch_add(&m->bytes_read, bytes_read, __ATOMIC_RELAXED);
+    if (bytes_written) __atomic_fetch_add(&m->bytes_written, bytes_written, __ATOMIC_RELAXED);
+    uint64_t max = __atomic_load_n(&m->max_ns, __ATOMIC_RELAXED);
+    while (ns > max && !__atomic_compare_exchange_n(&m->max_ns, &max, ns, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+/* Record an operation that started at metric_now() == start */
+static void metric_record(MetricOp op, uint64_t start, uint64_t bytes_read, uint64_t bytes_written) {
+    metric_record_ns(op, metric_now() - start, bytes_read, bytes_written);
+}
+
+static uint64_t file_bytes(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (uint64_t)st.st_size : 0;
+}
+
+/* Value at quantile q (0..1) of a histogram holding count values */
+static uint64_t metric_quantile(const uint64_t *buckets, uint64_t count, double q) {
+    uint64_t rank = (uint64_t)(q * count + 0.999999), seen = 0;
+    if (rank == 0) rank = 1;
+    for (int b = 0; b < METRIC_BUCKETS; ++b) {
+        seen += buckets[b];
+        if (seen >= rank) return metric_bucket_high(b);
+    }
+    return 0;
+}
+
+/* Print a table of the operations seen so far to out and write every
+   operation to path as one key=value line, for scraping:
+     op=NAME count=N mean_us=.. p50_us=.. p99_us=.. p999_us=.. max_us=.. bytes_read=N bytes_written=N
+   path is replaced atomically. Returns -1 if it cannot be written. */
+static int metrics_dump(FILE *out, const char *path) {
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "w");
+    fprintf(out, "\n%-18s %10s %10s %10s %10s %10s %12s %12s\n", "operation", "count", "p50_us",
+            "p99_us", "p999_us", "max_us", "read_bytes", "written_bytes");
+    for (int op = 0; op < M_COUNT; ++op) {
+        /* Copy first so all percentiles come from one snapshot */
+        uint64_t buckets[METRIC_BUCKETS];
+        const Metric *m = &metrics[op];
+        uint64_t count = 0;
+        for (int b = 0; b < METRIC_BUCKETS; ++b) {
+            buckets[b] = __atomic_load_n(&m->buckets[b], __ATOMIC_RELAXED);
+            count += buckets[b];
+        }
+        /* a bucket bound can overshoot the largest value actually seen */
+        uint64_t max_ns = __atomic_load_n(&m->max_ns, __ATOMIC_RELAXED);
+        uint64_t q50 = metric_quantile(buckets, count, 0.50);
+        uint64_t q99 = metric_quantile(buckets, count, 0.99);
+        uint64_t q999 = metric_quantile(buckets, count, 0.999);
+        double p50 = (q50 < max_ns ? q50 : max_ns) / 1e3;
+        double p99 = (q99 < max_ns ? q99 : max_ns) / 1e3;
+        double p999 = (q999 < max_ns ? q999 : max_ns) / 1e3;
+        double max = max_ns / 1e3;
+        double mean = count ? __atomic_load_n(&m->total_ns, __ATOMIC_RELAXED) / 1e3 / count : 0.0;
+        uint64_t rd = __atomic_load_n(&m->bytes_read, __ATOMIC_RELAXED);
+        uint64_t wr = __atomic_load_n(&m->bytes_written, __ATOMIC_RELAXED);
+        if (count)
+            fprintf(out, "%-18s %10llu %10.1f %10.1f %10.1f %10.1f %12llu %12llu\n", metric_names[op],
+                    (unsigned long long)count, p50, p99, p999, max, (unsigned long long)rd, (unsigned long long)wr);
+        if (f)
+            fprintf(f, "op=%s count=%llu mean_us=%.1f p50_us=%.1f p99_us=%.1f p999_us=%.1f max_us=%.1f "
+                    "bytes_read=%llu bytes_written=%llu\n", metric_names[op], (unsigned long long)count,
+                    mean, p50, p99, p999, max, (unsigned long long)rd, (unsigned long long)wr);
+    }
+    fflush(out);
+    if (!f || fclose(f) != 0 || rename(tmp, path) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/* SIGUSR1 dumps the metrics (to stderr and STATS_FILE) from a thread of its
+   own blocked in sigwait, so no work happens in signal context. Must run
+   before any other thread is created: they inherit the blocked mask. The
+   thread itself blocks every signal, so signals meant for the process
+   (SIGINT to a server) are never delivered to it. */
+static void *metrics_signal_main(void *arg) {
+    sigset_t *set = arg;
+    int sig;
+    while (sigwait(set, &sig) == 0) {
+        if (metrics_dump(stderr, STATS_FILE) != 0) fprintf(stderr, "Unable to write %s\n", STATS_FILE);
+    }
+    return NULL;
+}
+
+static int metrics_start_signal_thread(void) {
+    static sigset_t set;
+    sigset_t all, old;
+    pthread_t thread;
+    sigemptyset(&set);
+    sigaddset(&set, SIGUSR1);
+    sigfillset(&all);
+    if (pthread_sigmask(SIG_BLOCK, &all, &old) != 0) return -1;
+    int rc = pthread_create(&thread, NULL, metrics_signal_main, &set);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (rc != 0 || pthread_sigmask(SIG_BLOCK, &set, NULL) != 0) return -1;
+    return pthread_detach(thread);
+}
+
 /* ============================================================================
    UTILITY FUNCTIONS
    ============================================================================ */
@@ -60,6 +303,20 @@ static int is_alphabetic(const char *str) {
     return 1;
 }
 
+/* Withdrawal rule: the account must keep MIN_BALANCE. NULL = allowed. */
+static const char *withdraw_error(long balance, long amount) {
+    if (balance <= MIN_BALANCE) return "No available balance to withdraw (min balance 1000 required)";
+    if (amount <= 0) return "Invalid amount.";
+    if (balance - amount < MIN_BALANCE) return "Withdrawal denied.";
+    return NULL;
+}
+
+/* Deposit rule: MIN_DEPOSIT..MAX_DEPOSIT per transaction. NULL = allowed. */
+static const char *deposit_error(long amount) {
+    if (amount < MIN_DEPOSIT || amount > MAX_DEPOSIT) return "Invalid amount.";
+    return NULL;
+}
+
 /* utility: trim newline and whitespace */
 static void trim_newline(char *s) {
     if (!s) return;
@@ -70,6 +327,23 @@ static void trim_newline(char *s) {
     }
 }
 
+/* qsort/bsearch comparator for int and uint32_t arrays */
+static int cmp_int(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_uint32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Number of online CPUs, at least 1 */
+static int online_cpus(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
 /* Ensure file exists */
 void ensure_file_exists(const char *path) {
     FILE *f = fopen(path, "a");
@@ -80,7 +354,10 @@ void ensure_file_exists(const char *path) {
 static void read_line_input(const char *prompt, char *buf, size_t sz) {
     if (prompt) printf("%s", prompt);
     fflush(stdout);  // Ensure prompt is displayed
-    if (fgets(buf, (int)sz, stdin) == NULL) {
+    uint64_t t0 = metric_now();
+    char *got = fgets(buf, (int)sz, stdin);
+    metric_input_ns += metric_now() - t0;
+    if (got == NULL) {
         buf[0] = '\0';
         return;
     }
@@ -94,101 +371,520 @@ static void read_line_input(const char *prompt, char *buf, size_t sz) {
 }
 
 /* ============================================================================
-   EMPLOYEE FILE OPERATIONS
+   FIELD SCANNER
    ============================================================================ */
 
-int load_employees(Employee **out, int *count) {
-    ensure_file_exists(EMP_FILE);
-    FILE *f = fopen(EMP_FILE, "r");
-    if (!f) return -1;
-    Employee *arr = NULL;
-    int cap = 0, n = 0;
-    char line[MAX_LINE];
-    while (fgets(line, sizeof(line), f)) {
-        trim_newline(line);
-        if (line[0] == '\0') continue;
-        /* Format: id|name|salary|designation */
-        char *p = line;
-        char *parts[4] = {0};
-        int idx = 0;
-        parts[idx++] = p;
-        while (*p && idx < 4) {
-            if (*p == '|') { *p = '\0'; parts[idx++] = p+1; }
-            p++;
+/* The loaders find every '|' and '\n' of a block in one vectorized pass
+   (AVX2 or SSE2 on x86-64, picked at run time; scalar elsewhere) and slice
+   records out of the resulting position list. Numeric fields are converted
+   while their digits are walked, without copying or terminating them. */
+#define SCAN_BLOCK (64 * 1024)
+#define MAX_FIELDS 8
+
+typedef size_t (*DelimScanner)(const char *p, size_t len, uint32_t *pos);
+
+/* Offsets of every '|' and '\n' in p[0..len), in order; returns the count */
+static size_t scan_delims_scalar(const char *p, size_t len, uint32_t *pos) {
+    size_t n = 0;
+    for (size_t i = 0; i < len; ++i)
+        if (p[i] == '|' || p[i] == '\n') pos[n++] = (uint32_t)i;
+    return n;
+}
+
+#if defined(__x86_64__)
+static size_t scan_delims_sse2(const char *p, size_t len, uint32_t *pos) {
+    const __m128i bar = _mm_set1_epi8('|'), nl = _mm_set1_epi8('\n');
+    size_t n = 0, i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        uint32_t m = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, bar), _mm_cmpeq_epi8(v, nl)));
+        while (m) { pos[n++] = (uint32_t)(i + __builtin_ctz(m)); m &= m - 1; }
+    }
+    for (; i < len; ++i)
+        if (p[i] == '|' || p[i] == '\n') pos[n++] = (uint32_t)i;
+    return n;
+}
+
+__attribute__((target("avx2")))
+static size_t scan_delims_avx2(const char *p, size_t len, uint32_t *pos) {
+    const __m256i bar = _mm256_set1_epi8('|'), nl = _mm256_set1_epi8('\n');
+    size_t n = 0, i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        uint32_t m = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, bar), _mm256_cmpeq_epi8(v, nl)));
+        while (m) { pos[n++] = (uint32_t)(i + __builtin_ctz(m)); m &= m - 1; }
+    }
+    for (; i < len; ++i)
+        if (p[i] == '|' || p[i] == '\n') pos[n++] = (uint32_t)i;
+    return n;
+}
+#endif
+
+/* Best scanner for this CPU */
+static DelimScanner delim_scanner(void) {
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) return scan_delims_avx2;
+    return scan_delims_sse2;
+#else
+    return scan_delims_scalar;
+#endif
+}
+
+/* atol() over an unterminated field: leading blanks, optional sign, digits */
+static long parse_long_field(const char *p, const char *end) {
+    while (p < end && isspace((unsigned char)*p)) p++;
+    int neg = 0;
+    if (p < end && (*p == '-' || *p == '+')) neg = *p++ == '-';
+    unsigned long v = 0;
+    for (; p < end && (unsigned)(*p - '0') < 10; ++p) v = v * 10 + (unsigned)(*p - '0');
+    return neg ? -(long)v : (long)v;
+}
+
+/* Length strncpy(dst, field, size-1) would copy */
+static size_t field_len(const char *p, const char *end, size_t size) {
+    size_t len = (size_t)(end - p);
+    const char *nul = memchr(p, '\0', len);
+    if (nul) len = (size_t)(nul - p);
+    return len > size - 1 ? size - 1 : len;
+}
+
+/* Same result as strncpy(dst, field, size-1) followed by terminating */
+static void copy_field(char *dst, size_t size, const char *p, const char *end) {
+    size_t len = field_len(p, end, size);
+    memcpy(dst, p, len);
+    dst[len] = '\0';
+}
+
+/* ============================================================================
+   STRING ARENA
+   ============================================================================ */
+
+/* Terminated strings packed back to back in one growable buffer and named
+   by their offset. Offsets stay valid when the buffer moves; pointers
+   from arena_str do not survive the next arena_put. */
+static int arena_reserve(StrArena *a, size_t need) {
+    if (a->len + need <= a->cap) return 0;
+    if (a->len + need > UINT32_MAX) return -1;
+    size_t cap = a->cap ? a->cap : 4096;
+    while (cap < a->len + need) cap *= 2;
+    char *data = realloc(a->data, cap);
+    if (!data) return -1;
+    a->data = data;
+    a->cap = cap;
+    return 0;
+}
+
+/* Append s[0..len) plus a terminator; its offset goes to *off */
+static int arena_put(StrArena *a, const char *s, size_t len, uint32_t *off) {
+    if (arena_reserve(a, len + 1) != 0) return -1;
+    *off = (uint32_t)a->len;
+    memcpy(a->data + a->len, s, len);
+    a->data[a->len + len] = '\0';
+    a->len += len + 1;
+    return 0;
+}
+
+static const char *arena_str(const StrArena *a, uint32_t off) {
+    return a->data + off;
+}
+
+static void arena_free(StrArena *a) {
+    free(a->data);
+    a->data = NULL;
+    a->len = a->cap = 0;
+}
+
+/* ============================================================================
+   PARALLEL SORT
+   ============================================================================ */
+
+/* Sorts an array of record positions with a caller-supplied comparison.
+   The array is cut into one run per CPU, runs are qsorted on separate
+   threads and then merged pairwise. Arrays under SORT_PARALLEL_MIN are
+   sorted on the calling thread. */
+#define SORT_PARALLEL_MIN 65536
+#define SORT_MAX_RUNS 64
+
+typedef int (*PosCompare)(int a, int b);
+
+/* qsort passes no context, so the comparison of the sort in progress lives
+   here; one sort runs at a time */
+static PosCompare sort_cmp;
+
+static int sort_qsort_cmp(const void *a, const void *b) {
+    return sort_cmp(*(const int *)a, *(const int *)b);
+}
+
+typedef struct {
+    int *base;
+    size_t n;
+} SortRun;
+
+static void *sort_run(void *arg) {
+    SortRun *r = arg;
+    qsort(r->base, r->n, sizeof(int), sort_qsort_cmp);
+    return NULL;
+}
+
+static void sort_merge(const int *a, size_t na, const int *b, size_t nb, int *out) {
+    size_t i = 0, j = 0, k = 0;
+    while (i < na && j < nb) out[k++] = sort_cmp(b[j], a[i]) < 0 ? b[j++] : a[i++];
+    while (i < na) out[k++] = a[i++];
+    while (j < nb) out[k++] = b[j++];
+}
+
+static int sort_positions(int *pos, int n, PosCompare cmp) {
+    sort_cmp = cmp;
+    int runs = n < SORT_PARALLEL_MIN ? 1 : online_cpus();
+    if (runs > SORT_MAX_RUNS) runs = SORT_MAX_RUNS;
+    if (runs == 1) {
+        qsort(pos, n, sizeof(int), sort_qsort_cmp);
+        return 0;
+    }
+    int *tmp = malloc(n * sizeof(int));
+    if (!tmp) return -1;
+    SortRun run[SORT_MAX_RUNS];
+    pthread_t threads[SORT_MAX_RUNS];
+    size_t bound[SORT_MAX_RUNS + 1];
+    for (int r = 0; r <= runs; ++r) bound[r] = (size_t)n * r / runs;
+    for (int r = 0; r < runs; ++r) {
+        run[r].base = pos + bound[r];
+        run[r].n = bound[r+1] - bound[r];
+    }
+    int started = 0;
+    for (int r = 1; r < runs; ++r, ++started)
+        if (pthread_create(&threads[r], NULL, sort_run, &run[r]) != 0) break;
+    sort_run(&run[0]);
+    for (int r = started + 1; r < runs; ++r) sort_run(&run[r]);
+    for (int r = 1; r <= started; ++r) pthread_join(threads[r], NULL);
+
+    /* Merge neighbouring runs until one is left, alternating buffers */
+    int *src = pos, *dst = tmp;
+    while (runs > 1) {
+        int merged = 0;
+        for (int r = 0; r < runs; r += 2) {
+            size_t lo = bound[r], mid = bound[r + 1];
+            if (r + 1 == runs) memcpy(dst + lo, src + lo, (mid - lo) * sizeof(int));
+            else sort_merge(src + lo, mid - lo, src + mid, bound[r + 2] - mid, dst + lo);
+            bound[merged++] = lo;
         }
-        if (idx < 4) continue;
-        if (n == cap) {
-            cap = cap ? cap * 2 : 8;
-            arr = realloc(arr, cap * sizeof(Employee));
+        bound[merged] = (size_t)n;
+        runs = merged;
+        int *t = src; src = dst; dst = t;
+    }
+    if (src != pos) memcpy(pos, src, n * sizeof(int));
+    free(tmp);
+    return 0;
+}
+
+/* ============================================================================
+   PARALLEL LOADER
+   ============================================================================ */
+
+/* Data files are mapped and split into newline-aligned chunks that are
+   parsed on separate threads, each into its own buffer pre-sized from the
+   chunk's line count; the buffers are then concatenated in file order.
+   Files under LOAD_CHUNK_MIN bytes per thread are parsed on the calling
+   thread. Lines are split with the FIELD SCANNER; as before, blank lines and
+   lines with too few fields are skipped. Parsers that keep text in a STRING
+   ARENA get one per chunk, sized so it never grows. */
+#define LOAD_CHUNK_MIN (1 << 20)
+
+typedef int (*FieldParser)(const char *const *f, const char *const *e, void *out, StrArena *arena);
+
+typedef struct {
+    const char *begin, *end;
+    int nfields;
+    FieldParser parse;
+    size_t rec_size;
+    int use_arena;
+    char *recs;
+    int n;
+    StrArena arena;
+    int failed;
+} LoadChunk;
+
+/* One line ends at eol. Trailing '\r's are trimmed as trim_newline did,
+   then the line is skipped if blank or short of fields. */
+static void load_emit(LoadChunk *ch, const char **f, const char **e, int nf, const char *line, const char *eol) {
+    while (eol > f[nf-1] && eol[-1] == '\r') eol--;
+    if (eol == line || nf < ch->nfields) return;
+    e[nf-1] = eol;
+    if (ch->parse(f, e, ch->recs + (size_t)ch->n * ch->rec_size, &ch->arena) == 0) ch->n++;
+}
+
+static void *load_chunk(void *arg) {
+    LoadChunk *ch = arg;
+    size_t lines = 1;
+    for (const char *p = ch->begin; (p = memchr(p, '\n', ch->end - p)) != NULL; ++p) lines++;
+    ch->recs = malloc(lines * ch->rec_size);
+    uint32_t *pos = malloc(SCAN_BLOCK * sizeof(uint32_t));
+    /* A line's fields plus their terminators never outgrow the line */
+    if (ch->use_arena && arena_reserve(&ch->arena, (size_t)(ch->end - ch->begin) + lines) != 0) ch->failed = 1;
+    if (!ch->recs || !pos || ch->failed) { free(pos); ch->failed = 1; return NULL; }
+    DelimScanner scan = delim_scanner();
+    const char *f[MAX_FIELDS], *e[MAX_FIELDS];
+    const char *line = ch->begin;
+    int nf = 1;
+    f[0] = line;
+    for (const char *blk = ch->begin; blk < ch->end; blk += SCAN_BLOCK) {
+        size_t len = (size_t)(ch->end - blk) < SCAN_BLOCK ? (size_t)(ch->end - blk) : SCAN_BLOCK;
+        size_t n = scan(blk, len, pos);
+        for (size_t k = 0; k < n; ++k) {
+            const char *d = blk + pos[k];
+            if (*d == '|') {
+                /* Once all fields are found, further bars belong to the last one */
+                if (nf < ch->nfields) { e[nf-1] = d; f[nf++] = d + 1; }
+            } else {
+                load_emit(ch, f, e, nf, line, d);
+                line = d + 1;
+                nf = 1;
+                f[0] = line;
+            }
         }
-        Employee e;
-        e.id = atoi(parts[0]);
-        strncpy(e.name, parts[1], MAX_NAME-1); e.name[MAX_NAME-1] = '\0';
-        strncpy(e.salary, parts[2], sizeof(e.salary)-1); e.salary[sizeof(e.salary)-1] = '\0';
-        strncpy(e.designation, parts[3], MAX_DESIGN-1); e.designation[MAX_DESIGN-1] = '\0';
-        arr[n++] = e;
     }
-    fclose(f);
+    if (line < ch->end) load_emit(ch, f, e, nf, line, ch->end);
+    free(pos);
+    return NULL;
+}
+
+static void load_free(LoadChunk *chunks, int nchunks) {
+    for (int k = 0; k < nchunks; ++k) {
+        free(chunks[k].recs);
+        arena_free(&chunks[k].arena);
+    }
+    free(chunks);
+}
+
+/* Chunks are handed out to a pool of up to one thread per CPU, the calling
+   thread included, so several files are parsed at once */
+typedef struct {
+    LoadChunk *chunks;
+    int nchunks;
+    int next;               /* next chunk to claim */
+} LoadPool;
+
+static void *load_worker(void *arg) {
+    LoadPool *pool = arg;
+    int k;
+    while ((k = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->nchunks) load_chunk(&pool->chunks[k]);
+    return NULL;
+}
+
+typedef struct {
+    const char *data;
+    size_t size;
+    int nchunks;
+} LoadMap;
+
+/* Parse the files into per-chunk record buffers, in file order. The caller
+   merges them and releases them with load_free. */
+static int load_parallel_files(const char *const *paths, int npaths, size_t rec_size, int nfields,
+                               FieldParser parse, int use_arena, LoadChunk **out, int *nout) {
+    *out = NULL;
+    *nout = 0;
+    LoadMap *maps = calloc(npaths ? npaths : 1, sizeof(LoadMap));
+    if (!maps) return -1;
+    int cpus = online_cpus(), nchunks = 0, failed = 0;
+    for (int p = 0; p < npaths && !failed; ++p) {
+        int fd = open(paths[p], O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            if (fd >= 0) close(fd);
+            failed = 1;
+            break;
+        }
+        maps[p].size = (size_t)st.st_size;
+        if (maps[p].size > 0) {
+            maps[p].data = mmap(NULL, maps[p].size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (maps[p].data == MAP_FAILED) {
+                maps[p].data = NULL;
+                failed = 1;
+            } else {
+                madvise((void *)maps[p].data, maps[p].size, MADV_SEQUENTIAL);
+                maps[p].nchunks = cpus;
+                if ((size_t)maps[p].nchunks > maps[p].size / LOAD_CHUNK_MIN)
+                    maps[p].nchunks = (int)(maps[p].size / LOAD_CHUNK_MIN);
+                if (maps[p].nchunks < 1) maps[p].nchunks = 1;
+                nchunks += maps[p].nchunks;
+            }
+        }
+        close(fd);
+    }
+    LoadChunk *chunks = failed || nchunks == 0 ? NULL : calloc(nchunks, sizeof(LoadChunk));
+    if (!failed && nchunks > 0 && !chunks) failed = 1;
+    int k = 0;
+    for (int p = 0; p < npaths && !failed; ++p) {
+        const char *data = maps[p].data, *start = data, *end = data + maps[p].size;
+        for (int c = 0; c < maps[p].nchunks; ++c, ++k) {
+            const char *stop = end;
+            if (c < maps[p].nchunks - 1) {
+                stop = data + maps[p].size / maps[p].nchunks * (c + 1);
+                if (stop < start) stop = start;
+                const char *nl = memchr(stop, '\n', end - stop);
+                stop = nl ? nl + 1 : end;
+            }
+            chunks[k].begin = start;
+            chunks[k].end = stop;
+            chunks[k].nfields = nfields;
+            chunks[k].parse = parse;
+            chunks[k].rec_size = rec_size;
+            chunks[k].use_arena = use_arena;
+            start = stop;
+        }
+    }
+    if (!failed && nchunks > 0) {
+        LoadPool pool = { chunks, nchunks, 0 };
+        int nthreads = cpus < nchunks ? cpus : nchunks, started = 0;
+        pthread_t *threads = calloc(nthreads, sizeof(pthread_t));
+        for (int t = 1; threads && t < nthreads; ++t, ++started)
+            if (pthread_create(&threads[t], NULL, load_worker, &pool) != 0) break;
+        load_worker(&pool);
+        for (int t = 1; t <= started; ++t) pthread_join(threads[t], NULL);
+        free(threads);
+        for (k = 0; k < nchunks; ++k)
+            if (chunks[k].failed) failed = 1;
+    }
+    for (int p = 0; p < npaths; ++p)
+        if (maps[p].data) munmap((void *)maps[p].data, maps[p].size);
+    free(maps);
+    if (failed) {
+        if (chunks) load_free(chunks, nchunks);
+        return -1;
+    }
+    *out = chunks;
+    *nout = nchunks;
+    return 0;
+}
+
+static int load_parallel(const char *path, size_t rec_size, int nfields, FieldParser parse, int use_arena,
+                         LoadChunk **out, int *nout) {
+    return load_parallel_files(&path, 1, rec_size, nfields, parse, use_arena, out, nout);
+}
+
+/* ============================================================================
+   EMPLOYEE FILE OPERATIONS
+   ============================================================================ */
+
+/* Format: id|name|salary|designation */
+static int parse_employee_fields(const char *const *f, const char *const *e, void *out, StrArena *arena) {
+    (void)arena;
+    Employee *emp = out;
+    emp->id = (int)parse_long_field(f[0], e[0]);
+    copy_field(emp->name, MAX_NAME, f[1], e[1]);
+    copy_field(emp->salary, sizeof(emp->salary), f[2], e[2]);
+    copy_field(emp->designation, MAX_DESIGN, f[3], e[3]);
+    return 0;
+}
+
+int load_employees(Employee **out, int *count) {
+    uint64_t t0 = metric_now();
+    ensure_file_exists(EMP_FILE);
+    *out = NULL;
+    *count = 0;
+    LoadChunk *chunks; int nchunks;
+    if (load_parallel(EMP_FILE, sizeof(Employee), 4, parse_employee_fields, 0, &chunks, &nchunks) != 0) return -1;
+    int total = 0;
+    for (int k = 0; k < nchunks; ++k) total += chunks[k].n;
+    Employee *arr = malloc((total ? total : 1) * sizeof(Employee));
+    for (int k = 0, off = 0; arr && k < nchunks; off += chunks[k++].n)
+        memcpy(arr + off, chunks[k].recs, (size_t)chunks[k].n * sizeof(Employee));
+    load_free(chunks, nchunks);
+    if (!arr) return -1;
     *out = arr;
-    *count = n;
+    *count = total;
+    metric_record(M_LOAD_EMPLOYEES, t0, file_bytes(EMP_FILE), 0);
     return 0;
 }
 
+/* Written to a temporary file and renamed over employees.txt, so a crash
+   mid-write leaves the previous file (and its tombstones) in force */
 int save_employees(const Employee *emps, int count) {
-    FILE *f = fopen(EMP_FILE, "w");
+    uint64_t t0 = metric_now();
+    const char *tmp = EMP_FILE ".tmp";
+    FILE *f = fopen(tmp, "w");
     if (!f) return -1;
     for (int i = 0; i < count; ++i) {
         fprintf(f, "%d|%s|%s|%s\n", emps[i].id, emps[i].name, emps[i].salary, emps[i].designation);
     }
-    fclose(f);
+    if (fflush(f) != 0 || fsync(fileno(f)) != 0) { fclose(f); remove(tmp); return -1; }
+    long bytes = ftell(f);
+    if (fclose(f) != 0 || rename(tmp, EMP_FILE) != 0) { remove(tmp); return -1; }
+    metric_record(M_SAVE_EMPLOYEES, t0, 0, bytes > 0 ? bytes : 0);
     return 0;
 }
 
+/* Append many records in one write, made durable before returning */
+static int append_records(const char *path, const char *data, size_t len) {
+    int fd = open(path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    int rc = 0;
+    while (rc == 0 && len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) rc = -1;
+        else { data += n; len -= n; }
+    }
+    if (rc == 0 && fdatasync(fd) != 0) rc = -1;
+    if (close(fd) != 0) rc = -1;
+    return rc;
+}
+
+/* One new record, as durable as a bulk append */
 int append_employee(const Employee *e) {
-    ensure_file_exists(EMP_FILE);
-    FILE *f = fopen(EMP_FILE, "a");
-    if (!f) return -1;
-    fprintf(f, "%d|%s|%s|%s\n", e->id, e->name, e->salary, e->designation);
-    fclose(f);
+    uint64_t t0 = metric_now();
+    char line[sizeof(Employee) + 16];
+    int len = snprintf(line, sizeof(line), "%d|%s|%s|%s\n", e->id, e->name, e->salary, e->designation);
+    if (len < 0 || (size_t)len >= sizeof(line) || append_records(EMP_FILE, line, len) != 0) return -1;
+    metric_record(M_APPEND_EMPLOYEE, t0, 0, len);
     return 0;
 }
 
-/* ============================================================================
-   CUSTOMER FILE OPERATIONS
-   ============================================================================ */
+int append_employees(const Employee *emps, int count) {
+    uint64_t t0 = metric_now();
+    size_t cap = (size_t)count * (sizeof(Employee) + 16) + 1, len = 0;
+    char *buf = malloc(cap);
+    if (!buf) return -1;
+    for (int i = 0; i < count; ++i) {
+        len += snprintf(buf + len, cap - len, "%d|%s|%s|%s\n", emps[i].id, emps[i].name, emps[i].salary,
+                        emps[i].designation);
+    }
+    int rc = append_records(EMP_FILE, buf, len);
+    free(buf);
+    if (rc == 0) metric_record(M_APPEND_EMPLOYEE, t0, 0, len);
+    return rc;
+}
 
-int load_customers(Customer **out, int *count) {
-    ensure_file_exists(CUST_FILE);
-    FILE *f = fopen(CUST_FILE, "r");
-    if (!f) return -1;
-    Customer *arr = NULL;
-    int cap = 0, n = 0;
-    char line[MAX_LINE];
-    while (fgets(line, sizeof(line), f)) {
-        trim_newline(line);
-        if (line[0] == '\0') continue;
-        /* Format: account|name|aadhaar|phone|balance|address */
-        char *p = line;
-        char *parts[6] = {0};
-        int idx = 0;
-        parts[idx++] = p;
-        while (*p && idx < 6) {
-            if (*p == '|') { *p = '\0'; parts[idx++] = p+1; }
-            p++;
-        }
-        if (idx < 6) continue;
+/* A deleted employee stays in employees.txt until the next save; its ID is
+   appended to EMP_TOMBSTONES (one per line) and filtered out at load. IDs
+   are never reused, so the order of tombstones and records does not matter.
+   The IDs of one delete go out in a single durable append. */
+int append_employee_tombstones(const int *ids, int count) {
+    uint64_t t0 = metric_now();
+    char *buf = malloc((size_t)count * 12 + 1);
+    if (!buf) return -1;
+    size_t len = 0;
+    for (int i = 0; i < count; ++i) len += sprintf(buf + len, "%d\n", ids[i]);
+    int rc = append_records(EMP_TOMBSTONES, buf, len);
+    free(buf);
+    if (rc == 0) metric_record(M_APPEND_TOMBSTONE, t0, 0, len);
+    return rc;
+}
+
+int load_employee_tombstones(int **out, int *count) {
+    *out = NULL;
+    *count = 0;
+    FILE *f = fopen(EMP_TOMBSTONES, "r");
+    if (!f) return 0;
+    int *arr = NULL, cap = 0, n = 0, id;
+    while (fscanf(f, "%d", &id) == 1) {
         if (n == cap) {
-            cap = cap ? cap * 2 : 8;
-            arr = realloc(arr, cap * sizeof(Customer));
+            cap = cap ? cap * 2 : 64;
+            int *grown = realloc(arr, cap * sizeof(int));
+            if (!grown) { free(arr); fclose(f); return -1; }
+            arr = grown;
         }
-        Customer c;
-        c.account = atoi(parts[0]);
-        strncpy(c.name, parts[1], MAX_NAME-1); c.name[MAX_NAME-1] = '\0';
-        strncpy(c.aadhaar, parts[2], MAX_AAD-1); c.aadhaar[MAX_AAD-1] = '\0';
-        strncpy(c.phone, parts[3], MAX_PHONE-1); c.phone[MAX_PHONE-1] = '\0';
-        c.balance = atol(parts[4]);
-        strncpy(c.address, parts[5], MAX_ADDR-1); c.address[MAX_ADDR-1] = '\0';
-        arr[n++] = c;
+        arr[n++] = id;
     }
     fclose(f);
     *out = arr;
@@ -196,73 +892,4488 @@ int load_customers(Customer **out, int *count) {
     return 0;
 }
 
-int save_customers(const Customer *custs, int count) {
-    FILE *f = fopen(CUST_FILE, "w");
-    if (!f) return -1;
-    for (int i = 0; i < count; ++i) {
-        fprintf(f, "%d|%s|%s|%s|%ld|%s\n",
-                custs[i].account, custs[i].name, custs[i].aadhaar, custs[i].phone, custs[i].balance, custs[i].address);
+/* ============================================================================
+   CUSTOMER TABLE
+   ============================================================================ */
+
+/* Lookups, postings and balance totals only walk the 16-byte hot entries.
+   Text fields are reached through the hot entry's cold index, whose
+   offsets point into the STRING ARENA, so a customer costs 32 bytes plus
+   the length of its strings instead of the 344 of an inline Customer.
+   Changed text is appended rather than overwritten; once most of the arena
+   is garbage it is repacked. */
+#define CT_COMPACT_MIN (64 * 1024)
+
+static const size_t ct_field_size[CF_COUNT] = { MAX_NAME, MAX_AAD, MAX_PHONE, MAX_ADDR };
+
+static const char *ct_str(const CustTable *t, int i, CustField f) {
+    return arena_str(&t->arena, t->cold[t->hot[i].cold].off[f]);
+}
+
+/* Append a customer; text fields are cut to their Customer field sizes */
+int ct_append(CustTable *t, const Customer *c) {
+    if (t->count == t->cap) {
+        int cap = t->cap ? t->cap * 2 : 8;
+        CustHot *hot = realloc(t->hot, cap * sizeof(CustHot));
+        if (!hot) return -1;
+        t->hot = hot;
+        t->cap = cap;
     }
-    fclose(f);
+    if (t->cold_count == t->cold_cap) {
+        uint32_t cap = t->cold_cap ? t->cold_cap * 2 : 8;
+        CustCold *cold = realloc(t->cold, cap * sizeof(CustCold));
+        if (!cold) return -1;
+        t->cold = cold;
+        t->cold_cap = cap;
+    }
+    const char *src[CF_COUNT] = { c->name, c->aadhaar, c->phone, c->address };
+    CustCold *cold = &t->cold[t->cold_count];
+    for (int f = 0; f < CF_COUNT; ++f)
+        if (arena_put(&t->arena, src[f], strnlen(src[f], ct_field_size[f] - 1), &cold->off[f]) != 0) return -1;
+    CustHot *h = &t->hot[t->count++];
+    h->account = c->account;
+    h->cold = t->cold_count++;
+    h->balance = c->balance;
     return 0;
 }
 
-int append_customer(const Customer *c) {
-    ensure_file_exists(CUST_FILE);
-    FILE *f = fopen(CUST_FILE, "a");
-    if (!f) return -1;
-    fprintf(f, "%d|%s|%s|%s|%ld|%s\n", c->account, c->name, c->aadhaar, c->phone, c->balance, c->address);
-    fclose(f);
+/* Materialize record i */
+void ct_get(const CustTable *t, int i, Customer *out) {
+    char *dst[CF_COUNT] = { out->name, out->aadhaar, out->phone, out->address };
+    out->account = t->hot[i].account;
+    out->balance = t->hot[i].balance;
+    for (int f = 0; f < CF_COUNT; ++f) {
+        const char *s = ct_str(t, i, f);
+        copy_field(dst[f], ct_field_size[f], s, s + strlen(s));
+    }
+}
+
+/* Replace one text field of record i; the old string becomes garbage */
+int ct_set(CustTable *t, int i, CustField f, const char *value) {
+    uint32_t *off = &t->cold[t->hot[i].cold].off[f];
+    size_t old = strlen(arena_str(&t->arena, *off)) + 1;
+    uint32_t fresh;
+    if (arena_put(&t->arena, value, strnlen(value, ct_field_size[f] - 1), &fresh) != 0) return -1;
+    *off = fresh;
+    t->garbage += old;
     return 0;
 }
 
-/* ============================================================================
-   PRINT FUNCTIONS
-   ============================================================================ */
+/* Record i is about to be dropped from the hot array */
+void ct_release(CustTable *t, int i) {
+    for (int f = 0; f < CF_COUNT; ++f) t->garbage += strlen(ct_str(t, i, f)) + 1;
+}
 
-static void print_employees(const Employee *emps, int count) {
-    if (count == 0) {
-        printf("\n\tData file was empty\n");
-        return;
-    }
-    printf("\n--- Employees (%d) ---\n", count);
-    printf("%-6s | %-20s | %-10s | %-12s\n", "ID", "Name", "Salary", "Designation");
-    printf("---------------------------------------------------------------\n");
-    for (int i = 0; i < count; ++i) {
-        printf("%-6d | %-20s | %-10s | %-12s\n", emps[i].id, emps[i].name, emps[i].salary, emps[i].designation);
+/* Rebuild the cold entries and arena from the live records, in hot order.
+   Hot positions do not change, so indexes stay valid. */
+static int ct_compact(CustTable *t) {
+    StrArena arena = {0};
+    CustCold *cold = malloc((t->count ? t->count : 1) * sizeof(CustCold));
+    if (!cold || arena_reserve(&arena, t->arena.len - t->garbage) != 0) { free(cold); return -1; }
+    for (int i = 0; i < t->count; ++i) {
+        for (int f = 0; f < CF_COUNT; ++f) {
+            const char *s = ct_str(t, i, f);
+            if (arena_put(&arena, s, strlen(s), &cold[i].off[f]) != 0) {
+                free(cold);
+                arena_free(&arena);
+                return -1;
+            }
+        }
     }
+    for (int i = 0; i < t->count; ++i) t->hot[i].cold = (uint32_t)i;
+    free(t->cold);
+    arena_free(&t->arena);
+    t->cold = cold;
+    t->cold_count = (uint32_t)t->count;
+    t->cold_cap = t->count ? (uint32_t)t->count : 1;
+    t->arena = arena;
+    t->garbage = 0;
+    return 0;
 }
 
-static void print_customers(const Customer *custs, int count) {
-    if (count == 0) {
-        printf("\n\tData file was empty\n");
-        return;
-    }
-    printf("\n--- Customers (%d) ---\n", count);
-    printf("%-6s | %-20s | %-12s | %-10s | %-10s | %-20s\n", "Acc", "Name", "aadhaar", "Phone", "Balance", "Address");
-    printf("-----------------------------------------------------------------------------------------------\n");
-    for (int i = 0; i < count; ++i) {
-        printf("%-6d | %-20s | %-12s | %-10s | %-10ld | %-20s\n",
-               custs[i].account, custs[i].name, custs[i].aadhaar, custs[i].phone, custs[i].balance, custs[i].address);
-    }
+static void ct_maybe_compact(CustTable *t) {
+    if (t->garbage > CT_COMPACT_MIN && t->garbage * 2 > t->arena.len) ct_compact(t);
+}
+
+void ct_free(CustTable *t) {
+    free(t->hot);
+    free(t->cold);
+    arena_free(&t->arena);
+    memset(t, 0, sizeof(*t));
 }
 
 /* ============================================================================
-   MENU OPERATIONS
+   CUSTOMER SHARDS
    ============================================================================ */
 
-void create_new() {
-    printf("\n\t1. Employee\n\t2. Customer\n");
-    char buf[32];
-    read_line_input("\n\tEnter your choice: ", buf, sizeof(buf));
-    int ch = atoi(buf);
+/* The customer table can be split into files by account range.
+   CUST_MANIFEST lists the shards in ascending order, one first_account|file
+   line each; a shard holds the accounts from its first account up to the
+   next shard's, the first one also everything below and the last one
+   everything above. Without a manifest the table is the single CUST_FILE.
+   New accounts are the highest, so they are appended to the last shard
+   until a rebalance splits it. Shard files are never renamed: a split
+   writes its pieces under new numbers, replaces the manifest and only then
+   removes the old files, so a crash leaves either layout complete. */
+#define CUST_MANIFEST "customers.manifest"
+#define SHARD_MAX 256
+#define SHARD_PATH 32
+/* rebalance splits shards holding more rows than this by default */
+#define SHARD_SPLIT_ROWS 262144
+
+typedef struct {
+    int count;
+    int first[SHARD_MAX];       /* lowest account of each shard */
+    int file[SHARD_MAX];        /* N of customers.N.txt; -1 is CUST_FILE */
+} ShardMap;
+
+/* The layout of the data files in the current directory */
+static ShardMap cust_shards = { 1, { 0 }, { -1 } };
+
+static void shard_path(int file, char *out, size_t size) {
+    if (file < 0) snprintf(out, size, "%s", CUST_FILE);
+    else snprintf(out, size, "customers.%d.txt", file);
+}
+
+/* The last shard whose first account is not above account */
+static int shard_of(const ShardMap *m, int account) {
+    int lo = 1, hi = m->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (m->first[mid] <= account) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo - 1;
+}
+
+/* A missing manifest is the single-file layout; a malformed one fails */
+static int shard_map_load(ShardMap *m) {
+    m->count = 1;
+    m->first[0] = 0;
+    m->file[0] = -1;
+    FILE *f = fopen(CUST_MANIFEST, "r");
+    if (!f) return errno == ENOENT ? 0 : -1;
+    char line[MAX_LINE];
+    int n = 0, rc = 0;
+    while (fgets(line, sizeof(line), f)) {
+        int first, file;
+        if (n == SHARD_MAX || sscanf(line, "%d|customers.%d.txt", &first, &file) != 2 || file < 0 ||
+            (n > 0 && first <= m->first[n-1])) {
+            rc = -1;
+            break;
+        }
+        m->first[n] = first;
+        m->file[n++] = file;
+    }
+    fclose(f);
+    if (rc != 0 || n == 0) return -1;
+    m->count = n;
+    return 0;
+}
+
+/* Replaced atomically, like META_FILE; the single-file layout has none */
+static int shard_map_save(const ShardMap *m) {
+    if (m->count == 1 && m->file[0] < 0) return remove(CUST_MANIFEST) == 0 || errno == ENOENT ? 0 : -1;
+    FILE *f = fopen(CUST_MANIFEST ".tmp", "w");
+    if (!f) return -1;
+    for (int k = 0; k < m->count; ++k) fprintf(f, "%d|customers.%d.txt\n", m->first[k], m->file[k]);
+    if (fflush(f) != 0 || fsync(fileno(f)) != 0) { fclose(f); remove(CUST_MANIFEST ".tmp"); return -1; }
+    fclose(f);
+    return rename(CUST_MANIFEST ".tmp", CUST_MANIFEST);
+}
+
+static int shard_map_has(const ShardMap *m, int file) {
+    for (int k = 0; k < m->count; ++k)
+        if (m->file[k] == file) return 1;
+    return 0;
+}
+
+/* A file number no shard of m uses */
+static int shard_next_file(const ShardMap *m) {
+    int next = 0;
+    for (int k = 0; k < m->count; ++k)
+        if (m->file[k] >= next) next = m->file[k] + 1;
+    return next;
+}
+
+/* ============================================================================
+   CUSTOMER FILE OPERATIONS
+   ============================================================================ */
+
+/* A parsed line as the loader buffers it: cold offsets are relative to the
+   chunk's arena until load_customers merges the chunks */
+typedef struct {
+    CustHot hot;
+    CustCold cold;
+} CustRow;
+
+/* Format: account|name|aadhaar|phone|balance|address */
+static int parse_customer_fields(const char *const *f, const char *const *e, void *out, StrArena *arena) {
+    static const int col[CF_COUNT] = { 1, 2, 3, 5 };
+    CustRow *r = out;
+    r->hot.account = (int)parse_long_field(f[0], e[0]);
+    r->hot.balance = parse_long_field(f[4], e[4]);
+    for (int k = 0; k < CF_COUNT; ++k) {
+        const char *p = f[col[k]];
+        if (arena_put(arena, p, field_len(p, e[col[k]], ct_field_size[k]), &r->cold.off[k]) != 0) return -1;
+    }
+    return 0;
+}
+
+/* The original per-line loop (split in place, atoi/atol, strncpy). No
+   longer used for loading; kept as the baseline for bench-parse. */
+static int parse_customer_line(char *line, void *out) {
+    /* Format: account|name|aadhaar|phone|balance|address */
+    char *p = line;
+    char *parts[6] = {0};
+    int idx = 0;
+    parts[idx++] = p;
+    while (*p && idx < 6) {
+        if (*p == '|') { *p = '\0'; parts[idx++] = p+1; }
+        p++;
+    }
+    if (idx < 6) return -1;
+    Customer *c = out;
+    c->account = atoi(parts[0]);
+    strncpy(c->name, parts[1], MAX_NAME-1); c->name[MAX_NAME-1] = '\0';
+    strncpy(c->aadhaar, parts[2], MAX_AAD-1); c->aadhaar[MAX_AAD-1] = '\0';
+    strncpy(c->phone, parts[3], MAX_PHONE-1); c->phone[MAX_PHONE-1] = '\0';
+    c->balance = atol(parts[4]);
+    strncpy(c->address, parts[5], MAX_ADDR-1); c->address[MAX_ADDR-1] = '\0';
+    return 0;
+}
+
+/* Chunk arenas are concatenated and each row's offsets shifted by the
+   position its chunk's arena landed at. All shard files are parsed
+   together, and their records kept in shard order. */
+int load_customers(CustTable *t) {
+    uint64_t t0 = metric_now();
+    memset(t, 0, sizeof(*t));
+    if (shard_map_load(&cust_shards) != 0) return -1;
+    if (cust_shards.file[0] < 0) ensure_file_exists(CUST_FILE);
+    char names[SHARD_MAX][SHARD_PATH];
+    const char *paths[SHARD_MAX];
+    uint64_t file_total = 0;
+    for (int k = 0; k < cust_shards.count; ++k) {
+        shard_path(cust_shards.file[k], names[k], SHARD_PATH);
+        paths[k] = names[k];
+        file_total += file_bytes(names[k]);
+    }
+    LoadChunk *chunks; int nchunks;
+    if (load_parallel_files(paths, cust_shards.count, sizeof(CustRow), 6, parse_customer_fields, 1,
+                            &chunks, &nchunks) != 0) return -1;
+    int total = 0;
+    size_t bytes = 0;
+    for (int k = 0; k < nchunks; ++k) {
+        total += chunks[k].n;
+        bytes += chunks[k].arena.len;
+    }
+    int rc = -1;
+    t->hot = malloc((total ? total : 1) * sizeof(CustHot));
+    t->cold = malloc((total ? total : 1) * sizeof(CustCold));
+    if (t->hot && t->cold && arena_reserve(&t->arena, bytes) == 0) {
+        for (int k = 0; k < nchunks; ++k) {
+            uint32_t base = (uint32_t)t->arena.len;
+            const CustRow *rows = (const CustRow *)chunks[k].recs;
+            for (int r = 0; r < chunks[k].n; ++r) {
+                t->hot[t->count] = rows[r].hot;
+                t->hot[t->count].cold = (uint32_t)t->count;
+                for (int f = 0; f < CF_COUNT; ++f) t->cold[t->count].off[f] = rows[r].cold.off[f] + base;
+                t->count++;
+            }
+            memcpy(t->arena.data + t->arena.len, chunks[k].arena.data, chunks[k].arena.len);
+            t->arena.len += chunks[k].arena.len;
+        }
+        t->cap = total ? total : 1;
+        t->cold_count = (uint32_t)total;
+        t->cold_cap = (uint32_t)t->cap;
+        rc = 0;
+    }
+    load_free(chunks, nchunks);
+    if (rc != 0) ct_free(t);
+    else metric_record(M_LOAD_CUSTOMERS, t0, file_total, 0);
+    return rc;
+}
+
+/* Shards are rewritten by a pool of threads, each taking the next shard
+   due and writing the records of that shard in table order */
+typedef struct {
+    const CustTable *t;
+    const ShardMap *map;
+    const unsigned char *due;   /* NULL: every shard */
+    const int *order;           /* table positions grouped by shard */
+    const int *start;           /* shard k is order[start[k]..start[k+1]) */
+    int next;
+    int failed;
+    uint64_t bytes;
+} ShardSave;
+
+/* Written to a temporary file and renamed over the old one, so a crash
+   mid-write leaves the previous snapshot intact */
+static int save_shard(ShardSave *s, int k) {
+    char path[SHARD_PATH], tmp[SHARD_PATH + 4];
+    shard_path(s->map->file[k], path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "w");
+    if (!f) return -1;
+    const CustTable *t = s->t;
+    for (int r = s->start[k]; r < s->start[k+1]; ++r) {
+        int i = s->order[r];
+        fprintf(f, "%d|%s|%s|%s|%ld|%s\n", t->hot[i].account, ct_str(t, i, CF_NAME), ct_str(t, i, CF_AADHAAR),
+                ct_str(t, i, CF_PHONE), t->hot[i].balance, ct_str(t, i, CF_ADDRESS));
+    }
+    if (fflush(f) != 0 || fsync(fileno(f)) != 0) { fclose(f); remove(tmp); return -1; }
+    long bytes = ftell(f);
+    fclose(f);
+    if (rename(tmp, path) != 0) return -1;
+    if (bytes > 0) __atomic_fetch_add(&s->bytes, (uint64_t)bytes, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static void *save_shard_worker(void *arg) {
+    ShardSave *s = arg;
+    int k;
+    while ((k = __atomic_fetch_add(&s->next, 1, __ATOMIC_RELAXED)) < s->map->count) {
+        if (s->due && !s->due[k]) continue;
+        if (save_shard(s, k) != 0) __atomic_store_n(&s->failed, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+/* Rewrite the shards of map marked in due (all of them if due is NULL) */
+int save_customer_shards(const CustTable *t, const ShardMap *map, const unsigned char *due) {
+    uint64_t t0 = metric_now();
+    int nshards = map->count, ndue = 0;
+    for (int k = 0; k < nshards; ++k) ndue += !due || due[k];
+    if (ndue == 0) return 0;
+    int *start = calloc(nshards + 1, sizeof(int));
+    int *order = malloc((t->count ? t->count : 1) * sizeof(int));
+    int *shard = nshards > 1 ? malloc((t->count ? t->count : 1) * sizeof(int)) : NULL;
+    if (!start || !order || (nshards > 1 && !shard)) {
+        free(start); free(order); free(shard);
+        return -1;
+    }
+    if (nshards == 1) {
+        for (int i = 0; i < t->count; ++i) order[i] = i;
+        start[1] = t->count;
+    } else {
+        for (int i = 0; i < t->count; ++i) start[(shard[i] = shard_of(map, t->hot[i].account)) + 1]++;
+        for (int k = 0; k < nshards; ++k) start[k+1] += start[k];
+        int *fill = malloc(nshards * sizeof(int));
+        if (!fill) { free(start); free(order); free(shard); return -1; }
+        memcpy(fill, start, nshards * sizeof(int));
+        for (int i = 0; i < t->count; ++i) order[fill[shard[i]]++] = i;
+        free(fill);
+    }
+    ShardSave s = { t, map, due, order, start, 0, 0, 0 };
+    int nthreads = online_cpus() < ndue ? online_cpus() : ndue, started = 0;
+    pthread_t *threads = calloc(nthreads, sizeof(pthread_t));
+    for (int k = 1; threads && k < nthreads; ++k, ++started)
+        if (pthread_create(&threads[k], NULL, save_shard_worker, &s) != 0) break;
+    save_shard_worker(&s);
+    for (int k = 1; k <= started; ++k) pthread_join(threads[k], NULL);
+    free(threads);
+    free(start); free(order); free(shard);
+    if (s.failed) return -1;
+    metric_record(M_SAVE_CUSTOMERS, t0, 0, s.bytes);
+    return 0;
+}
+
+/* Rewrite the whole table in the layout found on disk */
+int save_customers(const CustTable *t) {
+    if (shard_map_load(&cust_shards) != 0) return -1;
+    return save_customer_shards(t, &cust_shards, NULL);
+}
+
+int append_customer(const Customer *c) {
+    uint64_t t0 = metric_now();
+    char path[SHARD_PATH];
+    shard_path(cust_shards.file[shard_of(&cust_shards, c->account)], path, sizeof(path));
+    char line[sizeof(Customer) + 32];
+    int len = snprintf(line, sizeof(line), "%d|%s|%s|%s|%ld|%s\n", c->account, c->name, c->aadhaar, c->phone,
+                       c->balance, c->address);
+    if (len < 0 || (size_t)len >= sizeof(line) || append_records(path, line, len) != 0) return -1;
+    metric_record(M_APPEND_CUSTOMER, t0, 0, len);
+    return 0;
+}
+
+/* Records first..first+count-1 of t, one write per run of records that
+   belong to the same shard */
+int append_customers(const CustTable *t, int first, int count) {
+    uint64_t t0 = metric_now();
+    size_t cap = (size_t)count * (sizeof(Customer) + 32) + 1, total = 0;
+    char *buf = malloc(cap);
+    if (!buf) return -1;
+    int rc = 0;
+    for (int i = first; rc == 0 && i < first + count;) {
+        int k = shard_of(&cust_shards, t->hot[i].account);
+        size_t len = 0;
+        for (; i < first + count && shard_of(&cust_shards, t->hot[i].account) == k; ++i) {
+            len += snprintf(buf + len, cap - len, "%d|%s|%s|%s|%ld|%s\n", t->hot[i].account,
+                            ct_str(t, i, CF_NAME), ct_str(t, i, CF_AADHAAR), ct_str(t, i, CF_PHONE),
+                            t->hot[i].balance, ct_str(t, i, CF_ADDRESS));
+        }
+        char path[SHARD_PATH];
+        shard_path(cust_shards.file[k], path, sizeof(path));
+        rc = append_records(path, buf, len);
+        total += len;
+    }
+    free(buf);
+    if (rc == 0) metric_record(M_APPEND_CUSTOMER, t0, 0, total);
+    return rc;
+}
+
+/* ============================================================================
+   ID SEQUENCES
+   ============================================================================ */
+
+/* The next employee ID and account number live in META_FILE rather than
+   being derived from the last record, so numbers freed by a delete are
+   never handed out again. Format: next_employee_id|next_account */
+int meta_load(int *next_emp, int *next_acc) {
+    *next_emp = *next_acc = 1;
+    FILE *f = fopen(META_FILE, "r");
+    if (!f) return -1;
+    int e, a;
+    int rc = fscanf(f, "%d|%d", &e, &a) == 2 ? 0 : -1;
+    fclose(f);
+    if (rc == 0) {
+        *next_emp = e;
+        *next_acc = a;
+    }
+    return rc;
+}
+
+/* Replaced atomically, like customers.txt */
+int meta_save(int next_emp, int next_acc) {
+    uint64_t t0 = metric_now();
+    FILE *f = fopen(META_FILE ".tmp", "w");
+    if (!f) return -1;
+    int bytes = fprintf(f, "%d|%d\n", next_emp, next_acc);
+    if (fflush(f) != 0 || fsync(fileno(f)) != 0) { fclose(f); remove(META_FILE ".tmp"); return -1; }
+    fclose(f);
+    if (rename(META_FILE ".tmp", META_FILE) != 0) return -1;
+    metric_record(M_META_SAVE, t0, 0, bytes > 0 ? bytes : 0);
+    return 0;
+}
+
+/* ============================================================================
+   TRANSACTION JOURNAL
+   ============================================================================ */
+
+/* Deposits and withdrawals are not written into customers.txt directly.
+   Each one is a fixed-size record appended to CUST_JOURNAL (see GROUP
+   COMMIT for how appends are batched), and the journal
+   is replayed on top of the snapshot at startup. Records carry the balance
+   after the posting as well as the delta, so replaying a record that the
+   snapshot already contains (crash between checkpoint and truncate) is
+   harmless. Deleting a customer appends a JOURNAL_DELETE tombstone the same
+   way; the record leaves customers.txt at the next checkpoint. Each record
+   also carries the sequence number of its CHANGE FEED line, so lines a
+   crash kept out of the feed are rewritten from the journal at startup. */
+#define JOURNAL_POST 0
+#define JOURNAL_DELETE 1
+
+typedef struct {
+    uint64_t seq;
+    int32_t account;
+    int32_t kind;       /* JOURNAL_POST or JOURNAL_DELETE (balance 0, amount minus the last balance) */
+    int64_t amount;     /* signed: deposit > 0, withdrawal < 0 */
+    int64_t balance;    /* balance after applying amount */
+    uint64_t change;    /* CHANGE FEED sequence number, 0 without a feed */
+    uint32_t crc;       /* crc32 of all preceding bytes */
+    uint32_t pad;
+} JournalRecord;
+
+static uint32_t crc32_table[256];
+static pthread_once_t crc32_once = PTHREAD_ONCE_INIT;
+
+static void crc32_init(void) {
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320U ^ (c >> 1) : c >> 1;
+        crc32_table[i] = c;
+    }
+}
+
+/* Posters, the committer and loader threads may all get here first */
+static uint32_t crc32_buf(const void *data, size_t len) {
+    pthread_once(&crc32_once, crc32_init);
+    const unsigned char *p = data;
+    uint32_t crc = 0xFFFFFFFFU;
+    while (len--) crc = crc32_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFU;
+}
+
+static uint32_t journal_crc(const JournalRecord *r) {
+    return crc32_buf(r, offsetof(JournalRecord, crc));
+}
+
+int journal_open(void) {
+    return open(CUST_JOURNAL, O_WRONLY | O_APPEND | O_CREAT, 0644);
+}
+
+/* Read every intact record. A torn or corrupt tail (crash mid-append) ends
+   the journal; it is cut off so later appends follow the last good record. */
+int journal_read(JournalRecord **out, int *count) {
+    uint64_t t0 = metric_now();
+    *out = NULL;
+    *count = 0;
+    int fd = open(CUST_JOURNAL, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return -1;
+    JournalRecord *arr = NULL;
+    int cap = 0, n = 0;
+    JournalRecord r;
+    while (read(fd, &r, sizeof(r)) == (ssize_t)sizeof(r)) {
+        if (r.crc != journal_crc(&r)) break;
+        if (n > 0 && r.seq != arr[n-1].seq + 1) break;
+        if (n == cap) {
+            cap = cap ? cap * 2 : 64;
+            JournalRecord *grown = realloc(arr, cap * sizeof(JournalRecord));
+            if (!grown) { free(arr); close(fd); return -1; }
+            arr = grown;
+        }
+        arr[n++] = r;
+    }
+    if (ftruncate(fd, (off_t)n * sizeof(JournalRecord)) != 0) { free(arr); close(fd); return -1; }
+    close(fd);
+    *out = arr;
+    *count = n;
+    metric_record(M_JOURNAL_READ, t0, (uint64_t)n * sizeof(JournalRecord), 0);
+    return 0;
+}
+
+void journal_record_init(JournalRecord *r, uint64_t seq, int kind, int account, long amount, long balance,
+                         uint64_t change) {
+    memset(r, 0, sizeof(*r));
+    r->seq = seq;
+    r->account = account;
+    r->kind = kind;
+    r->amount = amount;
+    r->balance = balance;
+    r->change = change;
+    r->crc = journal_crc(r);
+}
+
+int journal_reset(int fd) {
+    return ftruncate(fd, 0);
+}
+
+/* ============================================================================
+   BINARY STORAGE
+   ============================================================================ */
+
+/* Alternative to the text files: a 64-byte header followed by fixed-size
+   slots, where the record with key k (account number or employee ID) lives
+   in slot k-1 and a zero key marks an empty slot. The file is mapped with
+   mmap, so loading needs no parsing and a balance change is a single store
+   into the mapped record. The backend is used whenever customers.bin
+   exists; see the "convert" command. */
+#define BIN_VERSION 1
+#define BIN_MAX_SLOTS (1 << 26)
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t rec_size;
+    uint32_t slots;
+    uint32_t count;         /* occupied slots */
+    char reserved[40];
+} BinHeader;
+
+typedef struct {
+    int32_t id;             /* 0 = empty slot */
+    char name[MAX_NAME];
+    char salary[32];
+    char designation[MAX_DESIGN];
+} BinEmployee;
+
+typedef struct {
+    int32_t account;        /* 0 = empty slot */
+    char name[MAX_NAME];
+    char aadhaar[MAX_AAD];
+    char phone[MAX_PHONE];
+    int64_t balance;
+    char address[MAX_ADDR];
+} BinCustomer;
+
+typedef struct {
+    int fd;
+    unsigned char *map;
+    size_t size;
+    BinHeader *hdr;
+} BinFile;
+
+static int bin_map(BinFile *bf, size_t size) {
+    void *m = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, bf->fd, 0);
+    if (m == MAP_FAILED) return -1;
+    bf->map = m;
+    bf->size = size;
+    bf->hdr = (BinHeader *)m;
+    return 0;
+}
+
+/* Open (creating if needed) and map a binary table file */
+int bin_open(BinFile *bf, const char *path, const char *magic, uint32_t rec_size) {
+    bf->map = NULL;
+    bf->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (bf->fd < 0) return -1;
+    struct stat st;
+    if (fstat(bf->fd, &st) != 0) { close(bf->fd); return -1; }
+    if (st.st_size == 0) {
+        if (ftruncate(bf->fd, sizeof(BinHeader)) != 0 || bin_map(bf, sizeof(BinHeader)) != 0) {
+            close(bf->fd);
+            return -1;
+        }
+        memcpy(bf->hdr->magic, magic, sizeof(bf->hdr->magic));
+        bf->hdr->version = BIN_VERSION;
+        bf->hdr->rec_size = rec_size;
+        return 0;
+    }
+    if ((size_t)st.st_size < sizeof(BinHeader) || bin_map(bf, (size_t)st.st_size) != 0) {
+        close(bf->fd);
+        return -1;
+    }
+    if (memcmp(bf->hdr->magic, magic, sizeof(bf->hdr->magic)) != 0 || bf->hdr->version != BIN_VERSION ||
+        bf->hdr->rec_size != rec_size ||
+        bf->size < sizeof(BinHeader) + (size_t)bf->hdr->slots * rec_size) {
+        munmap(bf->map, bf->size);
+        close(bf->fd);
+        bf->map = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void bin_close(BinFile *bf) {
+    if (!bf->map) return;
+    munmap(bf->map, bf->size);
+    close(bf->fd);
+    bf->map = NULL;
+}
+
+int bin_sync(BinFile *bf) {
+    if (!bf->map) return 0;
+    uint64_t t0 = metric_now();
+    if (msync(bf->map, bf->size, MS_SYNC) != 0) return -1;
+    metric_record(M_BIN_SYNC, t0, 0, 0);
+    return 0;
+}
+
+/* Mapped slot for key, or NULL if key is outside the allocated range */
+static void *bin_slot(BinFile *bf, int key) {
+    if (key < 1 || (uint32_t)key > bf->hdr->slots) return NULL;
+    return bf->map + sizeof(BinHeader) + (size_t)(key - 1) * bf->hdr->rec_size;
+}
+
+/* Grow the file so that key has a slot; new slots read as empty (zero) */
+static void *bin_slot_reserve(BinFile *bf, int key) {
+    if (key < 1 || key > BIN_MAX_SLOTS) return NULL;
+    if ((uint32_t)key > bf->hdr->slots) {
+        uint32_t slots = bf->hdr->slots ? bf->hdr->slots : 1024;
+        while (slots < (uint32_t)key) slots *= 2;
+        if (slots > BIN_MAX_SLOTS) slots = BIN_MAX_SLOTS;
+        size_t size = sizeof(BinHeader) + (size_t)slots * bf->hdr->rec_size;
+        if (ftruncate(bf->fd, (off_t)size) != 0) return NULL;
+        /* Map the grown file before letting go of the old mapping, so a
+           failure leaves bf (and pointers into it) valid */
+        unsigned char *old = bf->map;
+        size_t old_size = bf->size;
+        if (bin_map(bf, size) != 0) return NULL;
+        munmap(old, old_size);
+        bf->hdr->slots = slots;
+    }
+    return bin_slot(bf, key);
+}
+
+static void bin_clear(BinFile *bf, int key) {
+    int32_t *slot = bin_slot(bf, key);
+    if (slot && *slot != 0) {
+        *slot = 0;
+        bf->hdr->count--;
+    }
+}
+
+int bin_put_employee(BinFile *bf, const Employee *e) {
+    BinEmployee *b = bin_slot_reserve(bf, e->id);
+    if (!b) return -1;
+    if (b->id == 0) bf->hdr->count++;
+    memset(b, 0, sizeof(*b));
+    b->id = e->id;
+    memcpy(b->name, e->name, MAX_NAME);
+    memcpy(b->salary, e->salary, sizeof(b->salary));
+    memcpy(b->designation, e->designation, MAX_DESIGN);
+    return 0;
+}
+
+int bin_put_customer(BinFile *bf, const Customer *c) {
+    BinCustomer *b = bin_slot_reserve(bf, c->account);
+    if (!b) return -1;
+    if (b->account == 0) bf->hdr->count++;
+    memset(b, 0, sizeof(*b));
+    b->account = c->account;
+    memcpy(b->name, c->name, MAX_NAME);
+    memcpy(b->aadhaar, c->aadhaar, MAX_AAD);
+    memcpy(b->phone, c->phone, MAX_PHONE);
+    b->balance = c->balance;
+    memcpy(b->address, c->address, MAX_ADDR);
+    return 0;
+}
+
+/* In-place balance update: one store into the mapped record */
+int bin_set_balance(BinFile *bf, int account, long balance) {
+    BinCustomer *b = bin_slot(bf, account);
+    if (!b || b->account != account) return -1;
+    b->balance = balance;
+    return 0;
+}
+
+int bin_load_employees(BinFile *bf, Employee **out, int *count) {
+    uint64_t t0 = metric_now();
+    Employee *arr = malloc((bf->hdr->count ? bf->hdr->count : 1) * sizeof(Employee));
+    if (!arr) return -1;
+    int n = 0;
+    for (uint32_t k = 1; k <= bf->hdr->slots && (uint32_t)n < bf->hdr->count; ++k) {
+        const BinEmployee *b = bin_slot(bf, (int)k);
+        if (b->id == 0) continue;
+        Employee *e = &arr[n++];
+        e->id = b->id;
+        memcpy(e->name, b->name, MAX_NAME); e->name[MAX_NAME-1] = '\0';
+        memcpy(e->salary, b->salary, sizeof(e->salary)); e->salary[sizeof(e->salary)-1] = '\0';
+        memcpy(e->designation, b->designation, MAX_DESIGN); e->designation[MAX_DESIGN-1] = '\0';
+    }
+    *out = arr;
+    *count = n;
+    metric_record(M_BIN_LOAD, t0, bf->size, 0);
+    return 0;
+}
+
+/* Records are copied into the CUSTOMER TABLE, which every index and scan
+   works on, so startup is one pass over the occupied slots: a copy per
+   record, but no parsing. Balance changes still go straight to the
+   mapping (bin_set_balance). */
+int bin_load_customers(BinFile *bf, CustTable *t) {
+    uint64_t t0 = metric_now();
+    memset(t, 0, sizeof(*t));
+    int n = 0;
+    for (uint32_t k = 1; k <= bf->hdr->slots && (uint32_t)n < bf->hdr->count; ++k) {
+        const BinCustomer *b = bin_slot(bf, (int)k);
+        if (b->account == 0) continue;
+        Customer c;
+        c.account = b->account;
+        memcpy(c.name, b->name, MAX_NAME); c.name[MAX_NAME-1] = '\0';
+        memcpy(c.aadhaar, b->aadhaar, MAX_AAD); c.aadhaar[MAX_AAD-1] = '\0';
+        memcpy(c.phone, b->phone, MAX_PHONE); c.phone[MAX_PHONE-1] = '\0';
+        c.balance = b->balance;
+        memcpy(c.address, b->address, MAX_ADDR); c.address[MAX_ADDR-1] = '\0';
+        if (ct_append(t, &c) != 0) { ct_free(t); return -1; }
+        n++;
+    }
+    metric_record(M_BIN_LOAD, t0, bf->size, 0);
+    return 0;
+}
+
+/* ============================================================================
+   COLUMNAR SNAPSHOTS
+   ============================================================================ */
+
+/* A read-only copy of a table for cold storage and analytics, stored
+   column by column in row groups of COL_GROUP_ROWS records:
+     header | column chunks ... | directory | trailer
+   The directory holds each group's row count and, for every column chunk,
+   its offset, size, crc32, encoding and, for integer columns, the group's
+   min and max, so a scan reads only the chunks of the columns it needs and
+   skips groups whose range cannot match. Encodings:
+     COL_DELTA   account, id: zigzag varints of the difference to the
+                 previous value, so ascending keys take about a byte each
+     COL_PACKED  balance, salary: the group minimum, then value - min in
+                 the fewest bits that hold the group's range
+     COL_DICT    designation: the group's distinct strings, then packed
+                 codes
+     COL_LZ      other text: NUL-separated strings, LZ77-compressed
+   A group with a salary that does not read back as the same number (e.g.
+   "007") stores its salaries as COL_LZ. See "convert to-col/from-col" and
+   "colscan". */
+#define EMP_COL "employees.col"
+#define CUST_COL "customers.col"
+#define COL_GROUP_ROWS 65536
+#define COL_MAX_COLS 6
+#define LZ_HASH_BITS 14
+#define LZ_MIN_MATCH 4
+#define LZ_WINDOW 65535
+
+enum { COL_DELTA, COL_PACKED, COL_DICT, COL_LZ };
+
+typedef struct {
+    const char *name;
+    int encoding;
+} ColDef;
+
+static const ColDef col_emp_defs[] = {
+    { "id", COL_DELTA }, { "name", COL_LZ }, { "salary", COL_PACKED }, { "designation", COL_DICT },
+};
+
+static const ColDef col_cust_defs[] = {
+    { "account", COL_DELTA }, { "name", COL_LZ }, { "aadhaar", COL_LZ },
+    { "phone", COL_LZ }, { "balance", COL_PACKED }, { "address", COL_LZ },
+};
+
+/* Customer text columns by position in col_cust_defs */
+static const int col_cust_field[COL_MAX_COLS] = { -1, CF_NAME, CF_AADHAAR, CF_PHONE, -1, CF_ADDRESS };
+
+typedef struct {
+    char magic[8];          /* "BNKCOL01" */
+    uint32_t employees;     /* 1 = employee table, 0 = customers */
+    uint32_t ncols;
+    uint32_t group_rows;
+    uint32_t reserved;
+} ColHeader;
+
+typedef struct {
+    uint64_t offset;
+    uint32_t size;
+    uint32_t crc;
+    uint32_t encoding;
+    uint32_t reserved;
+    int64_t min, max;       /* COL_DELTA and COL_PACKED only */
+} ColChunk;
+
+typedef struct {
+    uint64_t dir_offset;    /* uint32_t rows[ngroups], then ColChunk[ngroups][ncols] */
+    uint32_t ngroups;
+    uint32_t dir_crc;
+    uint64_t rows;
+    char magic[8];          /* "BNKCOLFT" */
+} ColTrailer;
+
+/* Growable output; a failed allocation sticks and later puts are dropped */
+typedef struct {
+    unsigned char *data;
+    size_t len, cap;
+    int failed;
+} ColBuf;
+
+static void cbuf_put(ColBuf *b, const void *p, size_t n) {
+    if (b->failed) return;
+    if (b->len + n > b->cap) {
+        size_t cap = b->cap ? b->cap : 4096;
+        while (cap < b->len + n) cap *= 2;
+        unsigned char *grown = realloc(b->data, cap);
+        if (!grown) { b->failed = 1; return; }
+        b->data = grown;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, p, n);
+    b->len += n;
+}
+
+static void cbuf_varint(ColBuf *b, uint64_t v) {
+    unsigned char out[10];
+    int n = 0;
+    while (v >= 0x80) { out[n++] = (unsigned char)(v | 0x80); v >>= 7; }
+    out[n++] = (unsigned char)v;
+    cbuf_put(b, out, n);
+}
+
+static int col_varint(const unsigned char **p, const unsigned char *end, uint64_t *v) {
+    *v = 0;
+    for (int shift = 0; shift < 64 && *p < end; shift += 7) {
+        unsigned char c = *(*p)++;
+        *v |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80)) return 0;
+    }
+    return -1;
+}
+
+static int col_bits(uint64_t range) {
+    int bits = 0;
+    while (bits < 64 && (range >> bits)) bits++;
+    return bits;
+}
+
+/* The group minimum, the width, then value - min in width bits each as
+   one little-endian bit stream of 64-bit words */
+static void col_pack(ColBuf *b, const int64_t *v, int n, int64_t min, int64_t max) {
+    unsigned char width = (unsigned char)col_bits((uint64_t)max - (uint64_t)min);
+    cbuf_put(b, &min, sizeof(min));
+    cbuf_put(b, &width, 1);
+    size_t words = ((uint64_t)n * width + 63) / 64;
+    uint64_t *w = calloc(words ? words : 1, sizeof(uint64_t));
+    if (!w) { b->failed = 1; return; }
+    for (int i = 0; width && i < n; ++i) {
+        uint64_t x = (uint64_t)v[i] - (uint64_t)min, pos = (uint64_t)i * width;
+        int s = (int)(pos % 64);
+        w[pos / 64] |= x << s;
+        if (s + width > 64) w[pos / 64 + 1] |= x >> (64 - s);
+    }
+    cbuf_put(b, w, words * sizeof(uint64_t));
+    free(w);
+}
+
+static int col_unpack(const unsigned char *p, const unsigned char *end, int n, int64_t *out) {
+    if (end - p < 9) return -1;
+    int64_t min;
+    memcpy(&min, p, sizeof(min));
+    int width = p[8];
+    p += 9;
+    if (width > 64 || (uint64_t)(end - p) < ((uint64_t)n * width + 63) / 64 * 8) return -1;
+    uint64_t mask = width == 64 ? ~0ULL : (1ULL << width) - 1;
+    for (int i = 0; i < n; ++i) {
+        uint64_t x = 0;
+        if (width) {
+            uint64_t pos = (uint64_t)i * width, lo, hi;
+            int s = (int)(pos % 64);
+            memcpy(&lo, p + pos / 64 * 8, 8);
+            x = lo >> s;
+            if (s + width > 64) {
+                memcpy(&hi, p + (pos / 64 + 1) * 8, 8);
+                x |= hi << (64 - s);
+            }
+        }
+        out[i] = (int64_t)((uint64_t)min + (x & mask));
+    }
+    return 0;
+}
+
+/* Sequences of: varint literal count, literals, varint match length
+   (0 ends the block, else length - LZ_MIN_MATCH + 1), 16-bit distance.
+   Matches are found through a hash of the next four bytes. */
+static void lz_compress(ColBuf *out, const unsigned char *src, size_t n, uint32_t *table) {
+    memset(table, 0, sizeof(uint32_t) << LZ_HASH_BITS);
+    size_t anchor = 0, i = 0;
+    while (n >= LZ_MIN_MATCH && i <= n - LZ_MIN_MATCH) {
+        uint32_t seq, prev;
+        memcpy(&seq, src + i, 4);
+        uint32_t h = (seq * 2654435761U) >> (32 - LZ_HASH_BITS);
+        size_t cand = table[h];
+        table[h] = (uint32_t)i + 1;
+        if (cand && i - (cand - 1) <= LZ_WINDOW && (memcpy(&prev, src + cand - 1, 4), prev == seq)) {
+            size_t m = cand - 1, len = LZ_MIN_MATCH;
+            while (i + len < n && src[m + len] == src[i + len]) len++;
+            cbuf_varint(out, i - anchor);
+            cbuf_put(out, src + anchor, i - anchor);
+            cbuf_varint(out, len - LZ_MIN_MATCH + 1);
+            uint16_t dist = (uint16_t)(i - m);
+            cbuf_put(out, &dist, sizeof(dist));
+            i += len;
+            anchor = i;
+        } else {
+            i++;
+        }
+    }
+    cbuf_varint(out, n - anchor);
+    cbuf_put(out, src + anchor, n - anchor);
+    cbuf_varint(out, 0);
+}
+
+static int lz_decompress(const unsigned char *p, const unsigned char *end, unsigned char *dst, size_t n) {
+    size_t o = 0;
+    for (;;) {
+        uint64_t lit, len;
+        if (col_varint(&p, end, &lit) != 0 || lit > n - o || lit > (uint64_t)(end - p)) return -1;
+        memcpy(dst + o, p, lit);
+        o += lit;
+        p += lit;
+        if (col_varint(&p, end, &len) != 0) return -1;
+        if (len == 0) return o == n ? 0 : -1;
+        len += LZ_MIN_MATCH - 1;
+        if (end - p < 2) return -1;
+        uint16_t dist;
+        memcpy(&dist, p, sizeof(dist));
+        p += 2;
+        if (dist == 0 || dist > o || len > n - o) return -1;
+        for (size_t k = 0; k < len; ++k) dst[o + k] = dst[o - dist + k];
+        o += len;
+    }
+}
+
+/* The table being written: emps, or cust when emps is NULL */
+typedef struct {
+    const Employee *emps;
+    const CustTable *cust;
+    int rows;
+} ColSource;
+
+static const char *col_source_str(const ColSource *s, int col, int r) {
+    if (!s->emps) return ct_str(s->cust, r, col_cust_field[col]);
+    if (col == 1) return s->emps[r].name;
+    return col == 2 ? s->emps[r].salary : s->emps[r].designation;
+}
+
+/* Integer columns; a salary fails (returns -1) unless it prints back the same */
+static int col_source_int(const ColSource *s, int col, int r, int64_t *v) {
+    if (!s->emps) {
+        *v = col == 0 ? s->cust->hot[r].account : s->cust->hot[r].balance;
+        return 0;
+    }
+    if (col == 0) {
+        *v = s->emps[r].id;
+        return 0;
+    }
+    char *end, back[32];
+    const char *salary = s->emps[r].salary;
+    *v = strtoll(salary, &end, 10);
+    snprintf(back, sizeof(back), "%lld", (long long)*v);
+    return *salary && !*end && strcmp(back, salary) == 0 ? 0 : -1;
+}
+
+static void col_encode_dict(ColBuf *b, const char *const *strs, int n, int64_t *codes) {
+    int slots = 16;
+    while (slots < 2 * n) slots *= 2;
+    int *slot = calloc(slots, sizeof(int));
+    const char **dict = malloc((n ? n : 1) * sizeof(char *));
+    if (!slot || !dict) { free(slot); free(dict); b->failed = 1; return; }
+    int ndict = 0;
+    for (int i = 0; i < n; ++i) {
+        uint32_t h = 2166136261U;
+        for (const char *p = strs[i]; *p; ++p) h = (h ^ (unsigned char)*p) * 16777619U;
+        int k = (int)(h & (uint32_t)(slots - 1));
+        while (slot[k] && strcmp(dict[slot[k] - 1], strs[i]) != 0) k = (k + 1) & (slots - 1);
+        if (!slot[k]) {
+            dict[ndict] = strs[i];
+            slot[k] = ++ndict;
+        }
+        codes[i] = slot[k] - 1;
+    }
+    cbuf_varint(b, (uint64_t)ndict);
+    for (int d = 0; d < ndict; ++d) cbuf_put(b, dict[d], strlen(dict[d]) + 1);
+    col_pack(b, codes, n, 0, ndict ? ndict - 1 : 0);
+    free(slot);
+    free(dict);
+}
+
+static void col_encode_lz(ColBuf *b, ColBuf *raw, const char *const *strs, int n, uint32_t *table) {
+    raw->len = 0;
+    for (int i = 0; i < n; ++i) cbuf_put(raw, strs[i], strlen(strs[i]) + 1);
+    if (raw->failed) { b->failed = 1; return; }
+    cbuf_varint(b, raw->len);
+    lz_compress(b, raw->data, raw->len, table);
+}
+
+/* Encode rows first..first+n-1 of one column into b, filling in c */
+static void col_encode(const ColSource *s, int col, int encoding, int first, int n, ColBuf *b, ColBuf *raw,
+                       int64_t *vals, const char **strs, uint32_t *table, ColChunk *c) {
+    c->encoding = (uint32_t)encoding;
+    c->min = c->max = 0;
+    if (encoding == COL_DELTA || encoding == COL_PACKED) {
+        for (int i = 0; i < n; ++i) {
+            if (col_source_int(s, col, first + i, &vals[i]) != 0) {
+                col_encode(s, col, COL_LZ, first, n, b, raw, vals, strs, table, c);
+                return;
+            }
+            if (i == 0 || vals[i] < c->min) c->min = vals[i];
+            if (i == 0 || vals[i] > c->max) c->max = vals[i];
+        }
+        if (encoding == COL_PACKED) {
+            col_pack(b, vals, n, c->min, c->max);
+            return;
+        }
+        int64_t prev = 0;
+        for (int i = 0; i < n; ++i) {
+            int64_t d = (int64_t)((uint64_t)vals[i] - (uint64_t)prev);
+            cbuf_varint(b, ((uint64_t)d << 1) ^ (uint64_t)(d >> 63));
+            prev = vals[i];
+        }
+        return;
+    }
+    for (int i = 0; i < n; ++i) strs[i] = col_source_str(s, col, first + i);
+    if (encoding == COL_DICT) col_encode_dict(b, strs, n, vals);
+    else col_encode_lz(b, raw, strs, n, table);
+}
+
+/* Written to a temporary file and renamed into place. Returns the size. */
+static long col_write(const char *path, const ColSource *s) {
+    uint64_t t0 = metric_now();
+    const ColDef *defs = s->emps ? col_emp_defs : col_cust_defs;
+    int ncols = s->emps ? 4 : 6;
+    int ngroups = (s->rows + COL_GROUP_ROWS - 1) / COL_GROUP_ROWS;
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "w");
+    uint32_t *rows = calloc(ngroups ? ngroups : 1, sizeof(uint32_t));
+    ColChunk *chunks = calloc((size_t)(ngroups ? ngroups : 1) * ncols, sizeof(ColChunk));
+    int64_t *vals = malloc(COL_GROUP_ROWS * sizeof(int64_t));
+    const char **strs = malloc(COL_GROUP_ROWS * sizeof(char *));
+    uint32_t *table = malloc(sizeof(uint32_t) << LZ_HASH_BITS);
+    ColBuf b = {0}, raw = {0};
+    int rc = f && rows && chunks && vals && strs && table ? 0 : -1;
+
+    ColHeader hdr = {0};
+    memcpy(hdr.magic, "BNKCOL01", 8);
+    hdr.employees = s->emps != NULL;
+    hdr.ncols = (uint32_t)ncols;
+    hdr.group_rows = COL_GROUP_ROWS;
+    uint64_t off = sizeof(hdr);
+    if (rc == 0 && fwrite(&hdr, sizeof(hdr), 1, f) != 1) rc = -1;
+    for (int g = 0; rc == 0 && g < ngroups; ++g) {
+        int first = g * COL_GROUP_ROWS;
+        rows[g] = (uint32_t)(s->rows - first < COL_GROUP_ROWS ? s->rows - first : COL_GROUP_ROWS);
+        for (int col = 0; rc == 0 && col < ncols; ++col) {
+            ColChunk *c = &chunks[(size_t)g * ncols + col];
+            b.len = 0;
+            col_encode(s, col, defs[col].encoding, first, (int)rows[g], &b, &raw, vals, strs, table, c);
+            c->offset = off;
+            c->size = (uint32_t)b.len;
+            c->crc = crc32_buf(b.data, b.len);
+            if (b.failed || raw.failed || fwrite(b.data, 1, b.len, f) != b.len) rc = -1;
+            off += b.len;
+        }
+    }
+    ColTrailer tr = {0};
+    tr.dir_offset = off;
+    tr.ngroups = (uint32_t)ngroups;
+    tr.rows = (uint64_t)s->rows;
+    memcpy(tr.magic, "BNKCOLFT", 8);
+    if (rc == 0) {
+        size_t nchunks = (size_t)ngroups * ncols;
+        uint32_t crc = crc32_buf(rows, ngroups * sizeof(uint32_t));
+        tr.dir_crc = crc ^ crc32_buf(chunks, nchunks * sizeof(ColChunk));
+        if (fwrite(rows, sizeof(uint32_t), ngroups, f) != (size_t)ngroups ||
+            fwrite(chunks, sizeof(ColChunk), nchunks, f) != nchunks || fwrite(&tr, sizeof(tr), 1, f) != 1)
+            rc = -1;
+    }
+    if (rc == 0 && (fflush(f) != 0 || fsync(fileno(f)) != 0)) rc = -1;
+    long bytes = f && rc == 0 ? ftell(f) : -1;
+    if (f) fclose(f);
+    if (rc == 0 && rename(tmp, path) != 0) rc = -1;
+    if (rc != 0) remove(tmp);
+    free(rows); free(chunks); free(vals); free(strs); free(table);
+    free(b.data); free(raw.data);
+    if (rc != 0) return -1;
+    metric_record(M_COL_WRITE, t0, 0, (uint64_t)bytes);
+    return bytes;
+}
+
+typedef struct {
+    int fd;
+    int employees;
+    uint32_t ncols, ngroups;
+    uint64_t rows;
+    uint32_t *group_rows;
+    ColChunk *chunks;       /* [group * ncols + column] */
+    uint64_t bytes_read;
+} ColFile;
+
+void col_close(ColFile *cf) {
+    if (cf->fd >= 0) close(cf->fd);
+    free(cf->group_rows);
+    free(cf->chunks);
+    cf->fd = -1;
+    cf->group_rows = NULL;
+    cf->chunks = NULL;
+}
+
+/* Read and check the header, trailer and directory of a table file */
+int col_open(ColFile *cf, const char *path, int employees) {
+    memset(cf, 0, sizeof(*cf));
+    cf->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (cf->fd < 0) return -1;
+    struct stat st;
+    ColHeader hdr;
+    ColTrailer tr;
+    uint32_t ncols = employees ? 4 : 6;
+    if (fstat(cf->fd, &st) != 0 || (size_t)st.st_size < sizeof(hdr) + sizeof(tr) ||
+        pread(cf->fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) ||
+        pread(cf->fd, &tr, sizeof(tr), st.st_size - sizeof(tr)) != (ssize_t)sizeof(tr) ||
+        memcmp(hdr.magic, "BNKCOL01", 8) != 0 || memcmp(tr.magic, "BNKCOLFT", 8) != 0 ||
+        hdr.employees != (uint32_t)(employees != 0) || hdr.ncols != ncols) {
+        col_close(cf);
+        return -1;
+    }
+    size_t nchunks = (size_t)tr.ngroups * ncols;
+    uint64_t dir_size = tr.ngroups * sizeof(uint32_t) + nchunks * sizeof(ColChunk);
+    cf->group_rows = malloc(tr.ngroups ? tr.ngroups * sizeof(uint32_t) : 1);
+    cf->chunks = malloc(nchunks ? nchunks * sizeof(ColChunk) : 1);
+    int rc = cf->group_rows && cf->chunks && tr.dir_offset + dir_size + sizeof(tr) == (uint64_t)st.st_size ? 0 : -1;
+    if (rc == 0 && (pread(cf->fd, cf->group_rows, tr.ngroups * sizeof(uint32_t), tr.dir_offset) !=
+                        (ssize_t)(tr.ngroups * sizeof(uint32_t)) ||
+                    pread(cf->fd, cf->chunks, nchunks * sizeof(ColChunk), tr.dir_offset + tr.ngroups * sizeof(uint32_t)) !=
+                        (ssize_t)(nchunks * sizeof(ColChunk))))
+        rc = -1;
+    if (rc == 0 && (crc32_buf(cf->group_rows, tr.ngroups * sizeof(uint32_t)) ^
+                    crc32_buf(cf->chunks, nchunks * sizeof(ColChunk))) != tr.dir_crc) rc = -1;
+    uint64_t rows = 0;
+    for (size_t k = 0; rc == 0 && k < nchunks; ++k)
+        if (cf->chunks[k].offset + cf->chunks[k].size > tr.dir_offset || cf->chunks[k].encoding > COL_LZ) rc = -1;
+    for (uint32_t g = 0; rc == 0 && g < tr.ngroups; ++g) {
+        if (cf->group_rows[g] > hdr.group_rows) rc = -1;
+        rows += cf->group_rows[g];
+    }
+    if (rc != 0 || rows != tr.rows || rows > INT_MAX) {
+        col_close(cf);
+        return -1;
+    }
+    cf->employees = employees != 0;
+    cf->ncols = ncols;
+    cf->ngroups = tr.ngroups;
+    cf->rows = rows;
+    return 0;
+}
+
+static const ColChunk *col_chunk(const ColFile *cf, int g, int col) {
+    return &cf->chunks[(size_t)g * cf->ncols + col];
+}
+
+/* One column chunk, checked against its crc; the caller frees it */
+static unsigned char *col_read(ColFile *cf, int g, int col) {
+    const ColChunk *c = col_chunk(cf, g, col);
+    unsigned char *data = malloc(c->size ? c->size : 1);
+    if (!data) return NULL;
+    if (pread(cf->fd, data, c->size, (off_t)c->offset) != (ssize_t)c->size || crc32_buf(data, c->size) != c->crc) {
+        free(data);
+        return NULL;
+    }
+    cf->bytes_read += c->size;
+    return data;
+}
+
+/* Decode a text chunk into out[0..rows). Returns the buffer the strings
+   live in, to be freed by the caller, or NULL. */
+static char *col_strings(ColFile *cf, int g, int col, const char **out) {
+    const ColChunk *c = col_chunk(cf, g, col);
+    int n = (int)cf->group_rows[g];
+    unsigned char *data = col_read(cf, g, col);
+    if (!data) return NULL;
+    const unsigned char *p = data, *end = data + c->size;
+    char *buf = NULL;
+    int rc = -1;
+    if (c->encoding == COL_LZ) {
+        uint64_t len;
+        if (col_varint(&p, end, &len) == 0 && len <= (uint64_t)n * MAX_LINE && (buf = malloc(len ? len : 1)) &&
+            lz_decompress(p, end, (unsigned char *)buf, len) == 0) {
+            char *s = buf;
+            rc = 0;
+            for (int i = 0; i < n; ++i) {
+                char *z = memchr(s, '\0', buf + len - s);
+                if (!z) { rc = -1; break; }
+                out[i] = s;
+                s = z + 1;
+            }
+        }
+        free(data);
+    } else if (c->encoding == COL_DICT) {
+        uint64_t ndict;
+        const char **dict = NULL;
+        int64_t *codes = malloc((n ? n : 1) * sizeof(int64_t));
+        if (codes && col_varint(&p, end, &ndict) == 0 && ndict <= (uint64_t)n &&
+            (dict = malloc((ndict ? ndict : 1) * sizeof(char *)))) {
+            rc = 0;
+            for (uint64_t d = 0; d < ndict; ++d) {
+                const unsigned char *z = memchr(p, '\0', end - p);
+                if (!z) { rc = -1; break; }
+                dict[d] = (const char *)p;
+                p = z + 1;
+            }
+            if (rc == 0 && col_unpack(p, end, n, codes) != 0) rc = -1;
+            for (int i = 0; i < n && rc == 0; ++i) {
+                if ((uint64_t)codes[i] >= ndict) rc = -1;
+                else out[i] = dict[codes[i]];
+            }
+        }
+        free(dict);
+        free(codes);
+        buf = (char *)data;
+    } else if (c->encoding == COL_PACKED) {
+        int64_t *vals = malloc((n ? n : 1) * sizeof(int64_t));
+        buf = malloc((size_t)(n ? n : 1) * 21);
+        if (vals && buf && col_unpack(p, end, n, vals) == 0) {
+            for (int i = 0; i < n; ++i) {
+                out[i] = buf + (size_t)i * 21;
+                snprintf(buf + (size_t)i * 21, 21, "%lld", (long long)vals[i]);
+            }
+            rc = 0;
+        }
+        free(vals);
+        free(data);
+    } else {
+        free(data);
+    }
+    if (rc != 0) {
+        free(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+/* Decode an integer chunk; a COL_LZ salary chunk is read as text */
+int col_ints(ColFile *cf, int g, int col, int64_t *out) {
+    const ColChunk *c = col_chunk(cf, g, col);
+    int n = (int)cf->group_rows[g];
+    if (c->encoding == COL_LZ || c->encoding == COL_DICT) {
+        const char **strs = malloc((n ? n : 1) * sizeof(char *));
+        char *buf = strs ? col_strings(cf, g, col, strs) : NULL;
+        for (int i = 0; buf && i < n; ++i) out[i] = atoll(strs[i]);
+        free(strs);
+        if (!buf) return -1;
+        free(buf);
+        return 0;
+    }
+    unsigned char *data = col_read(cf, g, col);
+    if (!data) return -1;
+    const unsigned char *p = data, *end = data + c->size;
+    int rc = 0;
+    if (c->encoding == COL_PACKED) {
+        rc = col_unpack(p, end, n, out);
+    } else {
+        int64_t prev = 0;
+        for (int i = 0; i < n && rc == 0; ++i) {
+            uint64_t z;
+            if (col_varint(&p, end, &z) != 0) rc = -1;
+            prev = (int64_t)((uint64_t)prev + ((z >> 1) ^ (~(z & 1) + 1)));
+            out[i] = prev;
+        }
+    }
+    free(data);
+    return rc;
+}
+
+int col_load_employees(const char *path, Employee **out, int *count) {
+    uint64_t t0 = metric_now();
+    ColFile cf;
+    *out = NULL;
+    *count = 0;
+    if (col_open(&cf, path, 1) != 0) return -1;
+    Employee *arr = calloc(cf.rows ? cf.rows : 1, sizeof(Employee));
+    int64_t *ids = malloc(COL_GROUP_ROWS * sizeof(int64_t));
+    const char **strs = malloc(COL_GROUP_ROWS * sizeof(char *));
+    int rc = arr && ids && strs ? 0 : -1, n = 0;
+    for (uint32_t g = 0; rc == 0 && g < cf.ngroups; ++g) {
+        int rows = (int)cf.group_rows[g];
+        if (col_ints(&cf, g, 0, ids) != 0) { rc = -1; break; }
+        for (int i = 0; i < rows; ++i) arr[n + i].id = (int)ids[i];
+        for (int col = 1; rc == 0 && col < 4; ++col) {
+            char *buf = col_strings(&cf, g, col, strs);
+            if (!buf) { rc = -1; break; }
+            for (int i = 0; i < rows; ++i) {
+                Employee *e = &arr[n + i];
+                char *dst = col == 1 ? e->name : col == 2 ? e->salary : e->designation;
+                size_t size = col == 1 ? MAX_NAME : col == 2 ? sizeof(e->salary) : MAX_DESIGN;
+                copy_field(dst, size, strs[i], strs[i] + strlen(strs[i]));
+            }
+            free(buf);
+        }
+        n += rows;
+    }
+    free(ids);
+    free(strs);
+    col_close(&cf);
+    if (rc != 0) { free(arr); return -1; }
+    metric_record(M_COL_READ, t0, cf.bytes_read, 0);
+    *out = arr;
+    *count = n;
+    return 0;
+}
+
+int col_load_customers(const char *path, CustTable *t) {
+    uint64_t t0 = metric_now();
+    ColFile cf;
+    memset(t, 0, sizeof(*t));
+    if (col_open(&cf, path, 0) != 0) return -1;
+    int64_t *acc = malloc(COL_GROUP_ROWS * sizeof(int64_t));
+    int64_t *bal = malloc(COL_GROUP_ROWS * sizeof(int64_t));
+    const char **strs[COL_MAX_COLS] = { NULL };
+    char *bufs[COL_MAX_COLS] = { NULL };
+    int rc = acc && bal ? 0 : -1;
+    for (int col = 0; col < COL_MAX_COLS; ++col)
+        if (col_cust_field[col] >= 0 && !(strs[col] = malloc(COL_GROUP_ROWS * sizeof(char *)))) rc = -1;
+    for (uint32_t g = 0; rc == 0 && g < cf.ngroups; ++g) {
+        if (col_ints(&cf, g, 0, acc) != 0 || col_ints(&cf, g, 4, bal) != 0) rc = -1;
+        for (int col = 0; rc == 0 && col < COL_MAX_COLS; ++col)
+            if (strs[col] && !(bufs[col] = col_strings(&cf, g, col, strs[col]))) rc = -1;
+        for (uint32_t i = 0; rc == 0 && i < cf.group_rows[g]; ++i) {
+            Customer c;
+            c.account = (int)acc[i];
+            c.balance = (long)bal[i];
+            copy_field(c.name, MAX_NAME, strs[1][i], strs[1][i] + strlen(strs[1][i]));
+            copy_field(c.aadhaar, MAX_AAD, strs[2][i], strs[2][i] + strlen(strs[2][i]));
+            copy_field(c.phone, MAX_PHONE, strs[3][i], strs[3][i] + strlen(strs[3][i]));
+            copy_field(c.address, MAX_ADDR, strs[5][i], strs[5][i] + strlen(strs[5][i]));
+            if (ct_append(t, &c) != 0) rc = -1;
+        }
+        for (int col = 0; col < COL_MAX_COLS; ++col) {
+            free(bufs[col]);
+            bufs[col] = NULL;
+        }
+    }
+    for (int col = 0; col < COL_MAX_COLS; ++col) free(strs[col]);
+    free(acc);
+    free(bal);
+    col_close(&cf);
+    if (rc != 0) ct_free(t);
+    else metric_record(M_COL_READ, t0, cf.bytes_read, 0);
+    return rc;
+}
+
+int col_write_employees(const char *path, const Employee *emps, int count, long *bytes) {
+    ColSource s = { emps, NULL, count };
+    return (*bytes = col_write(path, &s)) < 0 ? -1 : 0;
+}
+
+int col_write_customers(const char *path, const CustTable *t, long *bytes) {
+    ColSource s = { NULL, t, t->count };
+    return (*bytes = col_write(path, &s)) < 0 ? -1 : 0;
+}
+
+/* ============================================================================
+   CHANGE FEED
+   ============================================================================ */
+
+/* Every customer mutation is appended to a change feed that downstream
+   jobs can tail instead of re-reading customers.txt. One line per change:
+     seq|op|account|before|after|name|aadhaar|phone|address
+   op is CREATE, UPDATE, DELETE, DEPOSIT or WITHDRAW; before and after are
+   the balances around the change; the text fields are the record after a
+   CREATE or UPDATE and empty otherwise. Sequence numbers start at 1 and
+   never repeat, across restarts too. The feed is cut into segments of
+   FEED_SEGMENT_RECORDS lines, changes.000000.log holding 1..65536 and so
+   on, so a consumer resuming from a saved sequence number knows which
+   file to open. Finished segments (all but the newest) can be archived or
+   removed: the writer carries on from the newest one in the directory,
+   and a reader at the end of a segment moves on once a newer one exists,
+   a segment being complete by then. Lines
+   are written and synced by the GROUP COMMIT thread right after the
+   journal records of the postings they describe; a posting that reached
+   the journal but not the feed gets its line back from the journal at the
+   next start (store_backfill_feed). Creates, updates and binary-backend
+   postings have no journal record, so a crash in that window leaves a gap
+   in the numbering instead. */
+#define FEED_SEGMENT_RECORDS 65536
+#define FEED_PATH 40         /* "changes." + 20 digits + ".log" */
+
+enum { CHANGE_CREATE, CHANGE_UPDATE, CHANGE_DELETE, CHANGE_DEPOSIT, CHANGE_WITHDRAW };
+
+static const char *const change_names[] = { "CREATE", "UPDATE", "DELETE", "DEPOSIT", "WITHDRAW" };
+
+typedef struct {
+    uint64_t seq;
+    int op;
+    int account;
+    long before, after;
+    char *image;            /* name|aadhaar|phone|address, or NULL */
+} Change;
+
+typedef struct {
+    int fd;                 /* open segment, or -1 */
+    uint64_t segment;
+    uint64_t last_seq;      /* last sequence number durably written */
+    char *buf;
+    size_t cap;
+} ChangeFeed;
+
+static void feed_path(uint64_t segment, char *out, size_t size) {
+    snprintf(out, size, "changes.%06llu.log", (unsigned long long)segment);
+}
+
+static uint64_t feed_segment_of(uint64_t seq) {
+    return (seq - 1) / FEED_SEGMENT_RECORDS;
+}
+
+/* The feed op of a journal record */
+static int change_op(int kind, long amount) {
+    return kind == JOURNAL_DELETE ? CHANGE_DELETE : amount < 0 ? CHANGE_WITHDRAW : CHANGE_DEPOSIT;
+}
+
+/* Segment number of a feed file name; -1 if name is not one */
+static int feed_segment_name(const char *name, uint64_t *segment) {
+    if (strncmp(name, "changes.", 8) != 0 || !isdigit((unsigned char)name[8])) return -1;
+    char *end;
+    errno = 0;
+    *segment = strtoull(name + 8, &end, 10);
+    return errno == 0 && strcmp(end, ".log") == 0 ? 0 : -1;
+}
+
+/* Highest segment in the directory (0 if there is none). Older ones may
+   have been archived, so the directory is listed rather than probed. */
+static int feed_newest(uint64_t *newest) {
+    DIR *d = opendir(".");
+    if (!d) return -1;
+    *newest = 0;
+    struct dirent *e;
+    uint64_t segment;
+    while ((e = readdir(d)) != NULL)
+        if (feed_segment_name(e->d_name, &segment) == 0 && segment > *newest) *newest = segment;
+    closedir(d);
+    return 0;
+}
+
+/* Continue after the last complete line of the newest segment. A torn
+   line at its end (crash mid-append) is cut off. */
+int feed_open(ChangeFeed *feed) {
+    memset(feed, 0, sizeof(*feed));
+    feed->fd = -1;
+    char path[FEED_PATH];
+    uint64_t segment;
+    if (feed_newest(&segment) != 0) return -1;
+    feed_path(segment, path, sizeof(path));
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    feed->last_seq = segment * FEED_SEGMENT_RECORDS;
+    off_t keep = 0;
+    if (st.st_size > 0) {
+        /* Lines are short; the last one ends within the final MAX_LINE bytes */
+        char tail[MAX_LINE * 2];
+        off_t from = st.st_size > (off_t)sizeof(tail) ? st.st_size - (off_t)sizeof(tail) : 0;
+        ssize_t n = pread(fd, tail, (size_t)(st.st_size - from), from);
+        if (n != st.st_size - from) { close(fd); return -1; }
+        ssize_t end = n;
+        while (end > 0 && tail[end-1] != '\n') end--;
+        keep = from + end;
+        if (end > 0) {
+            ssize_t start = end - 1;
+            while (start > 0 && tail[start-1] != '\n') start--;
+            feed->last_seq = strtoull(tail + start, NULL, 10);
+        }
+    }
+    if (keep < st.st_size && ftruncate(fd, keep) != 0) { close(fd); return -1; }
+    feed->fd = fd;
+    feed->segment = segment;
+    return 0;
+}
+
+void feed_close(ChangeFeed *feed) {
+    if (feed->fd >= 0) close(feed->fd);
+    free(feed->buf);
+    feed->fd = -1;
+    feed->buf = NULL;
+    feed->cap = 0;
+}
+
+/* Append and sync the first len bytes of the buffer. Whatever a failed
+   write or sync left behind is cut off again, so the segment always ends
+   with a complete line and a retry does not follow a torn one. */
+static int feed_flush(ChangeFeed *feed, size_t len) {
+    if (len == 0) return 0;
+    off_t size = lseek(feed->fd, 0, SEEK_END);
+    if (size < 0) return -1;
+    const char *p = feed->buf;
+    while (len > 0) {
+        ssize_t n = write(feed->fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        p += n;
+        len -= n;
+    }
+    if (len == 0 && fdatasync(feed->fd) == 0) return 0;
+    if (ftruncate(feed->fd, size) != 0) {}
+    return -1;
+}
+
+/* Append a batch of numbered changes, one write and sync per segment
+   touched, and return how many of them are durable: all n unless a write
+   failed, in which case the rest should be retried. last_seq only moves
+   past lines that were synced. */
+int feed_write(ChangeFeed *feed, const Change *changes, int n) {
+    size_t len = 0;
+    int first = 0;          /* first change in the buffer */
+    for (int k = 0; k < n; ++k) {
+        uint64_t seq = changes[k].seq;
+        if (feed_segment_of(seq) != feed->segment) {
+            char path[FEED_PATH];
+            if (feed_flush(feed, len) != 0) return first;
+            if (k > first) feed->last_seq = changes[k-1].seq;
+            first = k;
+            len = 0;
+            feed_path(feed_segment_of(seq), path, sizeof(path));
+            int fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (fd < 0) return first;
+            close(feed->fd);
+            feed->fd = fd;
+            feed->segment = feed_segment_of(seq);
+        }
+        if (feed->cap - len < MAX_LINE + 128) {
+            size_t cap = feed->cap ? feed->cap * 2 : 65536;
+            char *grown = realloc(feed->buf, cap);
+            if (!grown) return first;
+            feed->buf = grown;
+            feed->cap = cap;
+        }
+        const Change *c = &changes[k];
+        len += snprintf(feed->buf + len, feed->cap - len, "%llu|%s|%d|%ld|%ld|%s\n", (unsigned long long)seq,
+                        change_names[c->op], c->account, c->before, c->after, c->image ? c->image : "|||");
+    }
+    if (feed_flush(feed, len) != 0) return first;
+    if (n > first) feed->last_seq = changes[n-1].seq;
+    return n;
+}
+
+/* ============================================================================
+   GROUP COMMIT
+   ============================================================================ */
+
+/* Postings are made durable in groups. A committer thread collects the
+   journal records of concurrent or back-to-back postings and writes them
+   with one write() and one fdatasync() (one msync() for the binary
+   backend). A batch is committed as soon as every poster in flight is
+   waiting on it, once it holds COMMIT_MAX_OPS postings, or COMMIT_WINDOW_US
+   after its first posting, and a poster is only acknowledged once its batch
+   is durable. BANKING_COMMIT_WINDOW_US and BANKING_COMMIT_MAX_OPS override
+   the limits at run time. The CHANGE FEED lines queued since the last
+   batch are written and synced after it. A feed failure does not fail the
+   batch, whose postings are durable already: the lines are held back and
+   retried with the next one, and gc_drain reports the feed as behind so a
+   checkpoint keeps the journal they can be rebuilt from. */
+#define COMMIT_WINDOW_US 2000
+#define COMMIT_MAX_OPS 256
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t work, durable;
+    pthread_t thread;
+    int running, stopping, draining, failed;
+    int fd;                     /* journal to append to, or -1 */
+    BinFile *bin;               /* mapping to msync, or NULL */
+    JournalRecord *pending, *spare;     /* filling / being written */
+    int npending, pending_cap, spare_cap;
+    uint64_t enqueued_seq, durable_seq;
+    int active, waiting;        /* posters in flight / blocked on durability */
+    long window_us;
+    int max_ops;
+    long batches, ops;          /* totals, for reporting */
+    int notify_fd;              /* eventfd bumped after every batch, or -1 */
+    ChangeFeed *feed;           /* or NULL */
+    Change *changes, *spare_changes;    /* filling / being written */
+    int nchanges, changes_cap, spare_changes_cap;
+    uint64_t changes_queued, changes_durable;
+    uint64_t change_seq;        /* last feed sequence number handed out */
+    Change *held;               /* lines a failed feed write left over; committer only */
+    int nheld, held_cap;
+    int feed_behind;            /* held is not empty */
+} GroupCommit;
+
+static long env_long(const char *name, long fallback) {
+    const char *v = getenv(name);
+    return v && is_numeric(v) ? atol(v) : fallback;
+}
+
+static void gc_free_changes(Change *changes, int n) {
+    for (int k = 0; k < n; ++k) free(changes[k].image);
+}
+
+/* Write the lines held back by an earlier failed batch, then this batch's.
+   Lines that still could not be written are held back for the next batch. */
+static int gc_feed(GroupCommit *gc, Change *changes, int n) {
+    if (gc->nheld > 0) {
+        int done = feed_write(gc->feed, gc->held, gc->nheld);
+        gc_free_changes(gc->held, done);
+        memmove(gc->held, gc->held + done, (gc->nheld - done) * sizeof(Change));
+        gc->nheld -= done;
+    }
+    int done = gc->nheld ? 0 : feed_write(gc->feed, changes, n);
+    gc_free_changes(changes, done);
+    if (done < n) {
+        int need = gc->nheld + n - done;
+        if (need > gc->held_cap) {
+            Change *grown = realloc(gc->held, need * sizeof(Change));
+            if (!grown) {
+                fprintf(stderr, "Change feed lines %llu to %llu were dropped\n",
+                        (unsigned long long)changes[done].seq, (unsigned long long)changes[n-1].seq);
+                gc_free_changes(changes + done, n - done);
+                return -1;
+            }
+            gc->held = grown;
+            gc->held_cap = need;
+        }
+        memcpy(gc->held + gc->nheld, changes + done, (n - done) * sizeof(Change));
+        gc->nheld = need;
+    }
+    return gc->nheld ? -1 : 0;
+}
+
+static void *gc_main(void *arg) {
+    GroupCommit *gc = arg;
+    pthread_mutex_lock(&gc->lock);
+    for (;;) {
+        while (gc->enqueued_seq == gc->durable_seq && gc->nchanges == 0 &&
+               !(gc->draining && gc->feed_behind) && !gc->stopping)
+            pthread_cond_wait(&gc->work, &gc->lock);
+        if (gc->enqueued_seq == gc->durable_seq && gc->nchanges == 0 && !(gc->draining && gc->feed_behind))
+            break;
+        /* Hold the batch open until it is full, everyone is waiting, or the window closes */
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += gc->window_us * 1000;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000;
+        deadline.tv_nsec %= 1000000000;
+        while ((long)(gc->enqueued_seq - gc->durable_seq) < gc->max_ops && gc->waiting < gc->active &&
+               !gc->draining && !gc->stopping) {
+            if (pthread_cond_timedwait(&gc->work, &gc->lock, &deadline) != 0) break;
+        }
+        JournalRecord *batch = gc->pending;
+        int n = gc->npending;
+        uint64_t upto = gc->enqueued_seq;
+        int cap = gc->pending_cap;
+        gc->pending = gc->spare;
+        gc->pending_cap = gc->spare_cap;
+        gc->spare = batch;
+        gc->spare_cap = cap;
+        gc->npending = 0;
+        Change *changes = gc->changes;
+        int nchanges = gc->nchanges;
+        uint64_t changes_upto = gc->changes_queued;
+        cap = gc->changes_cap;
+        gc->changes = gc->spare_changes;
+        gc->changes_cap = gc->spare_changes_cap;
+        gc->spare_changes = changes;
+        gc->spare_changes_cap = cap;
+        gc->nchanges = 0;
+        pthread_mutex_unlock(&gc->lock);
+
+        int err = 0;
+        if (gc->fd >= 0) {
+            uint64_t t0 = metric_now();
+            if (n > 0 && write(gc->fd, batch, n * sizeof(JournalRecord)) != (ssize_t)(n * sizeof(JournalRecord)))
+                err = 1;
+            if (!err && fdatasync(gc->fd) != 0) err = 1;
+            if (!err) metric_record(M_JOURNAL_COMMIT, t0, 0, (uint64_t)n * sizeof(JournalRecord));
+        }
+        if (gc->bin && bin_sync(gc->bin) != 0) err = 1;
+        int behind = 0;
+        if (gc->feed && (nchanges > 0 || gc->nheld > 0)) {
+            int was_behind = gc->nheld > 0;
+            behind = gc_feed(gc, changes, nchanges) != 0;
+            if (behind && !was_behind)
+                fprintf(stderr, "Change feed write failed (%s); retrying with the next batch\n", strerror(errno));
+        }
+
+        pthread_mutex_lock(&gc->lock);
+        gc->batches++;
+        gc->ops += (long)(upto - gc->durable_seq);
+        gc->durable_seq = upto;
+        gc->changes_durable = changes_upto;
+        gc->feed_behind = behind;
+        if (err) gc->failed = 1;
+        pthread_cond_broadcast(&gc->durable);
+        if (gc->notify_fd >= 0) {
+            uint64_t one = 1;
+            if (write(gc->notify_fd, &one, sizeof(one)) != sizeof(one)) {}
+        }
+    }
+    pthread_mutex_unlock(&gc->lock);
+    return NULL;
+}
+
+/* Start committing journal records to fd and/or syncing bin, and changes
+   to feed. Sequence numbers continue from last_seq. */
+int gc_start(GroupCommit *gc, int fd, BinFile *bin, ChangeFeed *feed, uint64_t last_seq) {
+    memset(gc, 0, sizeof(*gc));
+    gc->fd = fd;
+    gc->bin = bin;
+    gc->feed = feed;
+    gc->change_seq = feed ? feed->last_seq : 0;
+    gc->enqueued_seq = gc->durable_seq = last_seq;
+    gc->notify_fd = -1;
+    gc->window_us = env_long("BANKING_COMMIT_WINDOW_US", COMMIT_WINDOW_US);
+    gc->max_ops = (int)env_long("BANKING_COMMIT_MAX_OPS", COMMIT_MAX_OPS);
+    if (gc->max_ops < 1) gc->max_ops = 1;
+    pthread_mutex_init(&gc->lock, NULL);
+    pthread_cond_init(&gc->work, NULL);
+    pthread_cond_init(&gc->durable, NULL);
+    if (pthread_create(&gc->thread, NULL, gc_main, gc) != 0) return -1;
+    gc->running = 1;
+    return 0;
+}
+
+void gc_stop(GroupCommit *gc) {
+    if (!gc->running) return;
+    pthread_mutex_lock(&gc->lock);
+    gc->stopping = 1;
+    pthread_cond_signal(&gc->work);
+    pthread_mutex_unlock(&gc->lock);
+    pthread_join(gc->thread, NULL);
+    pthread_mutex_destroy(&gc->lock);
+    pthread_cond_destroy(&gc->work);
+    pthread_cond_destroy(&gc->durable);
+    free(gc->pending);
+    free(gc->spare);
+    free(gc->changes);
+    free(gc->spare_changes);
+    gc_free_changes(gc->held, gc->nheld);
+    free(gc->held);
+    gc->running = 0;
+}
+
+/* A poster announces itself before enqueueing, so the committer knows how
+   many postings may still join the open batch */
+void gc_begin(GroupCommit *gc) {
+    pthread_mutex_lock(&gc->lock);
+    gc->active++;
+    pthread_mutex_unlock(&gc->lock);
+}
+
+/* Queue a feed line for the next batch; image is taken over. Called with
+   gc->lock held. */
+static int gc_push_change(GroupCommit *gc, int op, int account, long before, long after, char *image) {
+    if (!gc->feed) { free(image); return 0; }
+    if (gc->nchanges == gc->changes_cap) {
+        int cap = gc->changes_cap ? gc->changes_cap * 2 : COMMIT_MAX_OPS;
+        Change *grown = realloc(gc->changes, cap * sizeof(Change));
+        if (!grown) { free(image); return -1; }
+        gc->changes = grown;
+        gc->changes_cap = cap;
+    }
+    Change *c = &gc->changes[gc->nchanges++];
+    c->seq = ++gc->change_seq;
+    c->op = op;
+    c->account = account;
+    c->before = before;
+    c->after = after;
+    c->image = image;
+    gc->changes_queued++;
+    return 0;
+}
+
+/* Queue a change that has no journal record (creates, updates, deferred
+   postings). It becomes durable with the next batch; gc_drain waits for it. */
+int gc_change(GroupCommit *gc, int op, int account, long before, long after, const char *image) {
+    char *copy = image ? strdup(image) : NULL;
+    if (image && !copy) return -1;
+    pthread_mutex_lock(&gc->lock);
+    int rc = -1;
+    if (gc->failed) free(copy);
+    else rc = gc_push_change(gc, op, account, before, after, copy);
+    if (rc == 0 && gc->nchanges == 1) pthread_cond_signal(&gc->work);
+    pthread_mutex_unlock(&gc->lock);
+    return rc;
+}
+
+/* Queue one posting (or tombstone, see JOURNAL_DELETE) and return its
+   sequence number (0 on failure). With a journal the record is queued for
+   the next batch write. balance is the balance after the change and
+   balance - amount the one before, which the feed line carries; the
+   record carries the line's sequence number. */
+uint64_t gc_enqueue(GroupCommit *gc, int kind, int account, long amount, long balance) {
+    pthread_mutex_lock(&gc->lock);
+    if (gc->failed) { pthread_mutex_unlock(&gc->lock); return 0; }
+    if (gc->fd >= 0 && gc->npending == gc->pending_cap) {
+        int cap = gc->pending_cap ? gc->pending_cap * 2 : COMMIT_MAX_OPS;
+        JournalRecord *grown = realloc(gc->pending, cap * sizeof(JournalRecord));
+        if (!grown) { pthread_mutex_unlock(&gc->lock); return 0; }
+        gc->pending = grown;
+        gc->pending_cap = cap;
+    }
+    if (gc_push_change(gc, change_op(kind, amount), account, balance - amount, balance, NULL) != 0) {
+        pthread_mutex_unlock(&gc->lock);
+        return 0;
+    }
+    uint64_t seq = ++gc->enqueued_seq;
+    if (gc->fd >= 0)
+        journal_record_init(&gc->pending[gc->npending++], seq, kind, account, amount, balance, gc->change_seq);
+    if (seq - gc->durable_seq == 1 || (long)(seq - gc->durable_seq) >= gc->max_ops)
+        pthread_cond_signal(&gc->work);
+    pthread_mutex_unlock(&gc->lock);
+    return seq;
+}
+
+/* Block until seq is durable and leave the in-flight set. seq 0 just leaves. */
+int gc_wait(GroupCommit *gc, uint64_t seq) {
+    pthread_mutex_lock(&gc->lock);
+    gc->waiting++;
+    if (gc->waiting == gc->active) pthread_cond_signal(&gc->work);
+    while (seq && gc->durable_seq < seq && !gc->failed) pthread_cond_wait(&gc->durable, &gc->lock);
+    int rc = (seq && gc->durable_seq >= seq) ? 0 : -1;
+    gc->waiting--;
+    gc->active--;
+    pthread_mutex_unlock(&gc->lock);
+    return rc;
+}
+
+/* Have the committer bump eventfd fd after every batch, for callers that
+   poll for durability instead of blocking in gc_wait */
+void gc_set_notify(GroupCommit *gc, int fd) {
+    pthread_mutex_lock(&gc->lock);
+    gc->notify_fd = fd;
+    pthread_mutex_unlock(&gc->lock);
+}
+
+/* Last durable sequence number; -1 once a batch has failed */
+int gc_durable(GroupCommit *gc, uint64_t *seq) {
+    pthread_mutex_lock(&gc->lock);
+    *seq = gc->durable_seq;
+    int rc = gc->failed ? -1 : 0;
+    pthread_mutex_unlock(&gc->lock);
+    return rc;
+}
+
+/* Sequence number of the last record queued */
+uint64_t gc_enqueued(GroupCommit *gc) {
+    pthread_mutex_lock(&gc->lock);
+    uint64_t seq = gc->enqueued_seq;
+    pthread_mutex_unlock(&gc->lock);
+    return seq;
+}
+
+/* Commit everything queued so far, without waiting for the window. A feed
+   that is behind gets one more try; -1 if it stays behind. */
+int gc_drain(GroupCommit *gc) {
+    pthread_mutex_lock(&gc->lock);
+    uint64_t upto = gc->enqueued_seq, changes = gc->changes_queued;
+    long batch = gc->batches;
+    gc->draining++;
+    pthread_cond_signal(&gc->work);
+    while ((gc->durable_seq < upto || gc->changes_durable < changes || (gc->feed_behind && gc->batches == batch)) &&
+           !gc->failed)
+        pthread_cond_wait(&gc->durable, &gc->lock);
+    gc->draining--;
+    int rc = gc->failed || gc->feed_behind ? -1 : 0;
+    pthread_mutex_unlock(&gc->lock);
+    return rc;
+}
+
+/* ============================================================================
+   HASH INDEXES
+   ============================================================================ */
+
+/* Open-addressing (linear probing) index from a record key to the record's
+   position in its table: the CUSTOMER TABLE for customer keys, the employee
+   array for KEY_EMP_ID. Each slot caches the key hash so most probes never
+   touch the record itself. */
+typedef enum { KEY_ACCOUNT, KEY_AADHAAR, KEY_PHONE, KEY_EMP_ID } KeyKind;
+
+typedef struct {
+    uint32_t hash;
+    int pos;            /* -1 = empty slot */
+} HashSlot;
+
+typedef struct {
+    KeyKind kind;
+    HashSlot *slots;
+    uint32_t cap;       /* always a power of two */
+    uint32_t used;
+} HashIndex;
+
+static uint32_t hash_int(int v) {
+    uint32_t x = (uint32_t)v;
+    x ^= x >> 16; x *= 0x7feb352dU;
+    x ^= x >> 15; x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+static uint32_t hash_str(const char *s) {
+    uint32_t h = 2166136261U;
+    while (*s) { h ^= (unsigned char)*s++; h *= 16777619U; }
+    return h;
+}
+
+/* table is a const CustTable * or, for KEY_EMP_ID, a const Employee * */
+static const void *hidx_rec_key(KeyKind kind, const void *table, int pos) {
+    switch (kind) {
+        case KEY_ACCOUNT: return &((const CustTable *)table)->hot[pos].account;
+        case KEY_AADHAAR: return ct_str(table, pos, CF_AADHAAR);
+        case KEY_PHONE:   return ct_str(table, pos, CF_PHONE);
+        default:          return &((const Employee *)table)[pos].id;
+    }
+}
+
+static int hidx_int_key(KeyKind kind) {
+    return kind == KEY_ACCOUNT || kind == KEY_EMP_ID;
+}
+
+static uint32_t hidx_hash_key(KeyKind kind, const void *key) {
+    return hidx_int_key(kind) ? hash_int(*(const int *)key) : hash_str((const char *)key);
+}
+
+static int hidx_key_equals(KeyKind kind, const void *table, int pos, const void *key) {
+    const void *rec = hidx_rec_key(kind, table, pos);
+    if (hidx_int_key(kind)) return *(const int *)rec == *(const int *)key;
+    return strcmp((const char *)rec, (const char *)key) == 0;
+}
+
+static int hidx_init(HashIndex *h, KeyKind kind, int expected) {
+    uint32_t cap = 16;
+    while (cap < (uint32_t)expected * 2) cap <<= 1;
+    h->slots = malloc(cap * sizeof(HashSlot));
+    if (!h->slots) return -1;
+    for (uint32_t i = 0; i < cap; ++i) h->slots[i].pos = -1;
+    h->kind = kind;
+    h->cap = cap;
+    h->used = 0;
+    return 0;
+}
+
+static void hidx_free(HashIndex *h) {
+    free(h->slots);
+    h->slots = NULL;
+    h->cap = h->used = 0;
+}
+
+/* Double the table; cached hashes mean no record is re-read */
+static int hidx_grow(HashIndex *h) {
+    uint32_t cap = h->cap * 2, mask = cap - 1;
+    HashSlot *slots = malloc(cap * sizeof(HashSlot));
+    if (!slots) return -1;
+    for (uint32_t i = 0; i < cap; ++i) slots[i].pos = -1;
+    for (uint32_t i = 0; i < h->cap; ++i) {
+        if (h->slots[i].pos < 0) continue;
+        uint32_t j = h->slots[i].hash & mask;
+        while (slots[j].pos >= 0) j = (j + 1) & mask;
+        slots[j] = h->slots[i];
+    }
+    free(h->slots);
+    h->slots = slots;
+    h->cap = cap;
+    return 0;
+}
+
+/* Position of the record holding this key, or -1 */
+static int hidx_find(const HashIndex *h, const void *t, const void *key) {
+    if (h->cap == 0) return -1;
+    uint32_t hv = hidx_hash_key(h->kind, key), mask = h->cap - 1;
+    for (uint32_t i = hv & mask; h->slots[i].pos >= 0; i = (i + 1) & mask) {
+        if (h->slots[i].hash == hv && hidx_key_equals(h->kind, t, h->slots[i].pos, key))
+            return h->slots[i].pos;
+    }
+    return -1;
+}
+
+/* Index the record at pos. Fails (returns -1) if its key is already indexed. */
+static int hidx_insert(HashIndex *h, const void *t, int pos) {
+    if ((h->used + 1) * 2 > h->cap && hidx_grow(h) != 0) return -1;
+    const void *key = hidx_rec_key(h->kind, t, pos);
+    uint32_t hv = hidx_hash_key(h->kind, key), mask = h->cap - 1;
+    uint32_t i = hv & mask;
+    for (; h->slots[i].pos >= 0; i = (i + 1) & mask) {
+        if (h->slots[i].hash == hv && hidx_key_equals(h->kind, t, h->slots[i].pos, key))
+            return -1;
+    }
+    h->slots[i].hash = hv;
+    h->slots[i].pos = pos;
+    h->used++;
+    return 0;
+}
+
+/* Drop the record at pos; must be called before its key is modified */
+static void hidx_remove(HashIndex *h, const void *t, int pos) {
+    if (h->cap == 0) return;
+    uint32_t mask = h->cap - 1;
+    uint32_t i = hidx_hash_key(h->kind, hidx_rec_key(h->kind, t, pos)) & mask;
+    while (h->slots[i].pos >= 0 && h->slots[i].pos != pos) i = (i + 1) & mask;
+    if (h->slots[i].pos < 0) return;
+    /* Backward-shift deletion keeps probe chains intact without tombstones */
+    for (uint32_t j = i;;) {
+        j = (j + 1) & mask;
+        if (h->slots[j].pos < 0) break;
+        uint32_t home = h->slots[j].hash & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            h->slots[i] = h->slots[j];
+            i = j;
+        }
+    }
+    h->slots[i].pos = -1;
+    h->used--;
+}
+
+/* ============================================================================
+   BALANCE INDEX
+   ============================================================================ */
+
+/* Skiplist of (balance, account) ordered by balance, highest first, ties by
+   account. The N largest balances are the first N nodes and a balance range
+   is one seek plus a walk, so both queries cost O(log N + k). Nodes hold
+   account numbers rather than table positions, so deletes elsewhere in the
+   table never invalidate them. */
+#define BIDX_MAX_LEVEL 24
+
+typedef struct SkipNode {
+    long balance;
+    int account;
+    struct SkipNode *next[];    /* one link per level of the node */
+} SkipNode;
+
+typedef struct {
+    SkipNode *head;             /* sentinel linked at every level */
+    int level;                  /* levels in use */
+    uint32_t rng;
+    int count;
+} BalanceIndex;
+
+/* a sorts before b: higher balance first, then lower account */
+static int bidx_before(long balance_a, int account_a, long balance_b, int account_b) {
+    return balance_a != balance_b ? balance_a > balance_b : account_a < account_b;
+}
+
+static SkipNode *bidx_node(int height, long balance, int account) {
+    SkipNode *n = malloc(sizeof(SkipNode) + height * sizeof(SkipNode *));
+    if (!n) return NULL;
+    n->balance = balance;
+    n->account = account;
+    return n;
+}
+
+/* Geometric height, p = 1/4 */
+static int bidx_height(BalanceIndex *b) {
+    int h = 1;
+    for (;;) {
+        b->rng ^= b->rng << 13; b->rng ^= b->rng >> 17; b->rng ^= b->rng << 5;
+        if ((b->rng & 3) != 0 || h == BIDX_MAX_LEVEL) return h;
+        h++;
+    }
+}
+
+static int bidx_init(BalanceIndex *b) {
+    b->head = bidx_node(BIDX_MAX_LEVEL, 0, 0);
+    if (!b->head) return -1;
+    for (int l = 0; l < BIDX_MAX_LEVEL; ++l) b->head->next[l] = NULL;
+    b->level = 1;
+    b->rng = 2463534242U;
+    b->count = 0;
+    return 0;
+}
+
+static void bidx_free(BalanceIndex *b) {
+    if (!b->head) return;
+    for (SkipNode *n = b->head->next[0], *next; n; n = next) {
+        next = n->next[0];
+        free(n);
+    }
+    free(b->head);
+    b->head = NULL;
+    b->count = 0;
+}
+
+/* Last node at each level that sorts before (balance, account) */
+static void bidx_find_prev(BalanceIndex *b, long balance, int account, SkipNode **prev) {
+    SkipNode *n = b->head;
+    for (int l = b->level - 1; l >= 0; --l) {
+        while (n->next[l] && bidx_before(n->next[l]->balance, n->next[l]->account, balance, account))
+            n = n->next[l];
+        prev[l] = n;
+    }
+}
+
+static int bidx_insert(BalanceIndex *b, long balance, int account) {
+    SkipNode *prev[BIDX_MAX_LEVEL];
+    bidx_find_prev(b, balance, account, prev);
+    int h = bidx_height(b);
+    SkipNode *n = bidx_node(h, balance, account);
+    if (!n) return -1;
+    for (; b->level < h; b->level++) prev[b->level] = b->head;
+    for (int l = 0; l < h; ++l) {
+        n->next[l] = prev[l]->next[l];
+        prev[l]->next[l] = n;
+    }
+    b->count++;
+    return 0;
+}
+
+static void bidx_remove(BalanceIndex *b, long balance, int account) {
+    SkipNode *prev[BIDX_MAX_LEVEL];
+    bidx_find_prev(b, balance, account, prev);
+    SkipNode *n = prev[0]->next[0];
+    if (!n || n->balance != balance || n->account != account) return;
+    for (int l = 0; l < b->level && prev[l]->next[l] == n; ++l) prev[l]->next[l] = n->next[l];
+    while (b->level > 1 && !b->head->next[b->level - 1]) b->level--;
+    free(n);
+    b->count--;
+}
+
+typedef struct {
+    long balance;
+    int account;
+} BalanceKey;
+
+static int cmp_balance_key(const void *a, const void *b) {
+    const BalanceKey *x = a, *y = b;
+    if (x->balance == y->balance && x->account == y->account) return 0;
+    return bidx_before(x->balance, x->account, y->balance, y->account) ? -1 : 1;
+}
+
+/* Bulk build: sort the keys once, then link nodes in order keeping the
+   tail of every level, instead of N separate searches. Takes ownership
+   of keys. */
+static int bidx_build_keys(BalanceIndex *b, BalanceKey *keys, int count) {
+    if (bidx_init(b) != 0) { free(keys); return -1; }
+    qsort(keys, count, sizeof(BalanceKey), cmp_balance_key);
+    SkipNode *tail[BIDX_MAX_LEVEL];
+    for (int l = 0; l < BIDX_MAX_LEVEL; ++l) tail[l] = b->head;
+    for (int i = 0; i < count; ++i) {
+        int h = bidx_height(b);
+        SkipNode *n = bidx_node(h, keys[i].balance, keys[i].account);
+        if (!n) { free(keys); return -1; }
+        for (int l = 0; l < h; ++l) {
+            n->next[l] = NULL;
+            tail[l]->next[l] = n;
+            tail[l] = n;
+        }
+        if (h > b->level) b->level = h;
+        b->count++;
+    }
+    free(keys);
+    return 0;
+}
+
+static int bidx_build(BalanceIndex *b, const CustTable *t) {
+    BalanceKey *keys = malloc((t->count ? t->count : 1) * sizeof(BalanceKey));
+    if (!keys) return -1;
+    for (int i = 0; i < t->count; ++i) {
+        keys[i].balance = t->hot[i].balance;
+        keys[i].account = t->hot[i].account;
+    }
+    return bidx_build_keys(b, keys, t->count);
+}
+
+/* Accounts with lo <= balance <= hi, highest balance first, at most max of
+   them; *out is malloc'd. Returns the number found or -1. */
+static int bidx_collect(const BalanceIndex *b, long lo, long hi, int max, int **out) {
+    *out = NULL;
+    SkipNode *n = b->head;
+    for (int l = b->level - 1; l >= 0; --l)
+        while (n->next[l] && n->next[l]->balance > hi) n = n->next[l];
+    int cap = 0, k = 0;
+    int *accounts = NULL;
+    for (n = n->next[0]; n && n->balance >= lo && k < max; n = n->next[0]) {
+        if (k == cap) {
+            cap = cap ? cap * 2 : 64;
+            int *grown = realloc(accounts, cap * sizeof(int));
+            if (!grown) { free(accounts); return -1; }
+            accounts = grown;
+        }
+        accounts[k++] = n->account;
+    }
+    *out = accounts;
+    return k;
+}
+
+/* ============================================================================
+   NAME INDEX
+   ============================================================================ */
+
+/* Prefix and fuzzy lookup over case-folded names. A trie answers "starts
+   with" by walking the prefix and listing its subtree, which comes out in
+   name order. Fuzzy queries count shared trigrams through per-trigram key
+   lists and verify the best candidates with an edit distance. Entries hold
+   record keys (account or employee ID) like the BALANCE INDEX. Trie nodes
+   are never freed; a node left without keys is skipped by later walks. */
+#define NAME_MAX_LEN 128
+#define NAME_GRAM_BUCKETS 65536
+#define NAME_FUZZY_VERIFY 4096      /* candidates checked by edit distance */
+#define NAME_FUZZY_CANDIDATES 32768 /* distinct keys a fuzzy query gathers */
+#define NAME_FUZZY_MAX 50
+
+typedef struct {
+    uint32_t child, sibling;    /* node indexes, 0 = none (node 0 is the root) */
+    uint32_t keys;              /* first NameKey of names ending here, 0 = none */
+    unsigned char c;
+} TrieNode;
+
+typedef struct {
+    int key;
+    uint32_t next;
+} NameKey;
+
+typedef struct {
+    int *keys;
+    int count, cap;
+} KeyList;
+
+typedef struct {
+    TrieNode *nodes;
+    uint32_t node_count, node_cap;
+    NameKey *entries;           /* entry 0 is unused so 0 can mean none */
+    uint32_t entry_count, entry_cap, free_entry;
+    KeyList *grams;             /* NAME_GRAM_BUCKETS lists of keys */
+} NameIndex;
+
+/* Name of the record holding key, or NULL if there is none */
+typedef const char *(*NameOf)(int key);
+
+static int klist_push(KeyList *l, int key) {
+    if (l->count == l->cap) {
+        int cap = l->cap ? l->cap * 2 : 4;
+        int *keys = realloc(l->keys, cap * sizeof(int));
+        if (!keys) return -1;
+        l->keys = keys;
+        l->cap = cap;
+    }
+    l->keys[l->count++] = key;
+    return 0;
+}
+
+/* Lowercase copy of at most NAME_MAX_LEN - 1 bytes; returns its length */
+static int name_fold(const char *s, char *out) {
+    int n = 0;
+    for (; s[n] && n < NAME_MAX_LEN - 1; ++n) out[n] = (char)tolower((unsigned char)s[n]);
+    out[n] = '\0';
+    return n;
+}
+
+/* Distinct trigram buckets of a folded name, padded as "  name " so the
+   start of the name weighs more than its middle. Returns the count. */
+static int name_grams(const char *folded, int len, uint32_t *out) {
+    char pad[NAME_MAX_LEN + 3];
+    if (len == 0) return 0;
+    pad[0] = pad[1] = ' ';
+    memcpy(pad + 2, folded, len);
+    pad[len + 2] = ' ';
+    int n = 0;
+    for (int i = 0; i + 3 <= len + 3; ++i) {
+        uint32_t g = (unsigned char)pad[i] << 16 | (unsigned char)pad[i+1] << 8 | (unsigned char)pad[i+2];
+        out[n++] = (g * 2654435761U) >> 16;
+    }
+    qsort(out, n, sizeof(uint32_t), cmp_uint32);
+    int u = 0;
+    for (int i = 0; i < n; ++i)
+        if (u == 0 || out[u-1] != out[i]) out[u++] = out[i];
+    return u;
+}
+
+static int nidx_init(NameIndex *x) {
+    memset(x, 0, sizeof(*x));
+    x->grams = calloc(NAME_GRAM_BUCKETS, sizeof(KeyList));
+    x->nodes = calloc(1, sizeof(TrieNode));
+    x->entries = calloc(1, sizeof(NameKey));
+    if (!x->grams || !x->nodes || !x->entries) return -1;
+    x->node_count = x->node_cap = 1;
+    x->entry_count = x->entry_cap = 1;
+    return 0;
+}
+
+static void nidx_free(NameIndex *x) {
+    if (x->grams)
+        for (int b = 0; b < NAME_GRAM_BUCKETS; ++b) free(x->grams[b].keys);
+    free(x->grams);
+    free(x->nodes);
+    free(x->entries);
+    memset(x, 0, sizeof(*x));
+}
+
+/* Room for n more nodes, so node links can be held across the insert */
+static int nidx_reserve_nodes(NameIndex *x, uint32_t n) {
+    if (x->node_count + n <= x->node_cap) return 0;
+    uint32_t cap = x->node_cap * 2;
+    while (cap < x->node_count + n) cap *= 2;
+    TrieNode *nodes = realloc(x->nodes, cap * sizeof(TrieNode));
+    if (!nodes) return -1;
+    x->nodes = nodes;
+    x->node_cap = cap;
+    return 0;
+}
+
+static uint32_t nidx_new_entry(NameIndex *x) {
+    if (x->free_entry) {
+        uint32_t e = x->free_entry;
+        x->free_entry = x->entries[e].next;
+        return e;
+    }
+    if (x->entry_count == x->entry_cap) {
+        uint32_t cap = x->entry_cap * 2;
+        NameKey *entries = realloc(x->entries, cap * sizeof(NameKey));
+        if (!entries) return 0;
+        x->entries = entries;
+        x->entry_cap = cap;
+    }
+    return x->entry_count++;
+}
+
+/* Child of node n labelled c, or 0 */
+static uint32_t nidx_child(const NameIndex *x, uint32_t n, unsigned char c) {
+    uint32_t m = x->nodes[n].child;
+    while (m && x->nodes[m].c < c) m = x->nodes[m].sibling;
+    return m && x->nodes[m].c == c ? m : 0;
+}
+
+static int nidx_add(NameIndex *x, const char *name, int key) {
+    char folded[NAME_MAX_LEN];
+    uint32_t grams[NAME_MAX_LEN + 1];
+    int len = name_fold(name, folded);
+    if (nidx_reserve_nodes(x, len) != 0) return -1;
+    uint32_t n = 0;
+    for (int i = 0; i < len; ++i) {
+        unsigned char c = (unsigned char)folded[i];
+        /* siblings are kept sorted so a subtree walk yields name order */
+        uint32_t *link = &x->nodes[n].child;
+        while (*link && x->nodes[*link].c < c) link = &x->nodes[*link].sibling;
+        if (!*link || x->nodes[*link].c != c) {
+            uint32_t m = x->node_count++;
+            x->nodes[m].c = c;
+            x->nodes[m].child = x->nodes[m].keys = 0;
+            x->nodes[m].sibling = *link;
+            *link = m;
+        }
+        n = *link;
+    }
+    uint32_t e = nidx_new_entry(x);
+    if (!e) return -1;
+    x->entries[e].key = key;
+    x->entries[e].next = x->nodes[n].keys;
+    x->nodes[n].keys = e;
+    int ng = name_grams(folded, len, grams);
+    for (int g = 0; g < ng; ++g)
+        if (klist_push(&x->grams[grams[g]], key) != 0) return -1;
+    return 0;
+}
+
+/* Drop key, indexed under name; must be called before the name changes */
+static void nidx_remove(NameIndex *x, const char *name, int key) {
+    char folded[NAME_MAX_LEN];
+    uint32_t grams[NAME_MAX_LEN + 1];
+    int len = name_fold(name, folded);
+    uint32_t n = 0;
+    for (int i = 0; i < len && (n = nidx_child(x, n, (unsigned char)folded[i])) != 0; ++i) {}
+    if (n || len == 0) {
+        for (uint32_t *link = &x->nodes[n].keys; *link; link = &x->entries[*link].next) {
+            if (x->entries[*link].key != key) continue;
+            uint32_t e = *link;
+            *link = x->entries[e].next;
+            x->entries[e].next = x->free_entry;
+            x->free_entry = e;
+            break;
+        }
+    }
+    int ng = name_grams(folded, len, grams);
+    for (int g = 0; g < ng; ++g) {
+        KeyList *l = &x->grams[grams[g]];
+        for (int k = 0; k < l->count; ++k) {
+            if (l->keys[k] != key) continue;
+            l->keys[k] = l->keys[--l->count];
+            break;
+        }
+    }
+}
+
+static int nidx_walk(const NameIndex *x, uint32_t n, KeyList *out) {
+    int first = out->count;
+    for (uint32_t e = x->nodes[n].keys; e; e = x->entries[e].next)
+        if (klist_push(out, x->entries[e].key) != 0) return -1;
+    /* keys are pushed at the head of a node's list; restore insertion order */
+    for (int i = first, j = out->count - 1; i < j; ++i, --j) {
+        int t = out->keys[i]; out->keys[i] = out->keys[j]; out->keys[j] = t;
+    }
+    for (uint32_t m = x->nodes[n].child; m; m = x->nodes[m].sibling)
+        if (nidx_walk(x, m, out) != 0) return -1;
+    return 0;
+}
+
+/* Keys of all names starting with prefix, in name order; *out is malloc'd.
+   Returns the number found or -1. */
+static int nidx_prefix(const NameIndex *x, const char *prefix, int **out) {
+    char folded[NAME_MAX_LEN];
+    int len = name_fold(prefix, folded);
+    KeyList found = {0};
+    uint32_t n = 0;
+    for (int i = 0; i < len && (n = nidx_child(x, n, (unsigned char)folded[i])) != 0; ++i) {}
+    if ((n || len == 0) && nidx_walk(x, n, &found) != 0) {
+        free(found.keys);
+        *out = NULL;
+        return -1;
+    }
+    *out = found.keys;
+    return found.count;
+}
+
+/* Optimal string alignment distance: edits, adjacent swaps included */
+static int name_distance(const char *a, int la, const char *b, int lb) {
+    int rows[3][NAME_MAX_LEN + 1];
+    int *pp = rows[0], *p = rows[1], *cur = rows[2];
+    for (int j = 0; j <= lb; ++j) p[j] = j;
+    for (int i = 1; i <= la; ++i) {
+        cur[0] = i;
+        for (int j = 1; j <= lb; ++j) {
+            int cost = a[i-1] != b[j-1];
+            int d = p[j-1] + cost;
+            if (p[j] + 1 < d) d = p[j] + 1;
+            if (cur[j-1] + 1 < d) d = cur[j-1] + 1;
+            if (i > 1 && j > 1 && a[i-1] == b[j-2] && a[i-2] == b[j-1] && pp[j-2] + 1 < d)
+                d = pp[j-2] + 1;
+            cur[j] = d;
+        }
+        int *t = pp; pp = p; p = cur; cur = t;
+    }
+    return p[lb];
+}
+
+typedef struct {
+    int key;
+    int hits;                   /* trigrams shared with the query, 0 = empty slot */
+    int distance;
+} NameMatch;
+
+static int cmp_name_match(const void *a, const void *b) {
+    const NameMatch *x = a, *y = b;
+    if (x->distance != y->distance) return x->distance - y->distance;
+    if (x->hits != y->hits) return y->hits - x->hits;
+    return (x->key > y->key) - (x->key < y->key);
+}
+
+/* Keys of the names closest to query, nearest first, at most max of them;
+   a name matches within 1 + len/4 edits. *out is malloc'd. Returns the
+   number found or -1. */
+static int nidx_fuzzy(const NameIndex *x, const char *query, NameOf name_of, int max, int **out) {
+    char folded[NAME_MAX_LEN], other[NAME_MAX_LEN];
+    uint32_t grams[NAME_MAX_LEN + 1];
+    int len = name_fold(query, folded);
+    int ng = name_grams(folded, len, grams);
+    int limit = 1 + len / 4, n = 0;
+    *out = NULL;
+
+    /* An edit changes at most three trigrams, so a match shares at least
+       need of the query's and must be in one of its ng - need + 1 rarest
+       trigram lists. Only those lists add candidates, at most
+       NAME_FUZZY_CANDIDATES of them, rarest first; the commoner lists
+       just count hits, which keeps the scratch table small for names made
+       of common trigrams. */
+    int need = ng - 3 * limit > 1 ? ng - 3 * limit : 1;
+    for (int g = 1; g < ng; ++g) {
+        uint32_t v = grams[g];
+        int h = g;
+        for (; h > 0 && x->grams[grams[h-1]].count > x->grams[v].count; --h) grams[h] = grams[h-1];
+        grams[h] = v;
+    }
+    int gather = ng - need + 1;
+    long total = 0;
+    for (int g = 0; g < gather; ++g) total += x->grams[grams[g]].count;
+    if (total == 0) return 0;
+    if (total > NAME_FUZZY_CANDIDATES) total = NAME_FUZZY_CANDIDATES;
+
+    /* Count shared trigrams per key in a scratch hash table */
+    uint32_t cap = 16;
+    while (cap < (uint64_t)total * 2) cap <<= 1;
+    NameMatch *slots = calloc(cap, sizeof(NameMatch));
+    int *per_hits = calloc(ng + 1, sizeof(int));
+    if (!slots || !per_hits) { free(slots); free(per_hits); return -1; }
+    long used = 0;
+    for (int g = 0; g < ng; ++g) {
+        const KeyList *l = &x->grams[grams[g]];
+        for (int k = 0; k < l->count; ++k) {
+            uint32_t i = hash_int(l->keys[k]) & (cap - 1);
+            while (slots[i].hits && slots[i].key != l->keys[k]) i = (i + 1) & (cap - 1);
+            if (!slots[i].hits) {
+                if (g >= gather || used == total) continue;
+                used++;
+            }
+            slots[i].key = l->keys[k];
+            slots[i].hits++;
+        }
+    }
+
+    /* Verify only the keys sharing the most trigrams: the lowest hit count
+       that keeps at most NAME_FUZZY_VERIFY candidates */
+    for (uint32_t i = 0; i < cap; ++i) if (slots[i].hits) per_hits[slots[i].hits]++;
+    int min_hits = ng, above = per_hits[ng];
+    while (min_hits > need && above + per_hits[min_hits - 1] <= NAME_FUZZY_VERIFY)
+        above += per_hits[--min_hits];
+    for (uint32_t i = 0; i < cap && n < NAME_FUZZY_VERIFY; ++i) {
+        if (slots[i].hits < min_hits) continue;
+        const char *name = name_of(slots[i].key);
+        if (!name) continue;
+        int olen = name_fold(name, other);
+        if (abs(olen - len) > limit) continue;
+        int d = name_distance(folded, len, other, olen);
+        if (d > limit) continue;
+        slots[n] = slots[i];        /* n <= i, so the slot was already read */
+        slots[n++].distance = d;
+    }
+    free(per_hits);
+    qsort(slots, n, sizeof(NameMatch), cmp_name_match);
+    if (n > max) n = max;
+    int *keys = malloc((n ? n : 1) * sizeof(int));
+    if (!keys) { free(slots); return -1; }
+    for (int k = 0; k < n; ++k) keys[k] = slots[k].key;
+    free(slots);
+    *out = keys;
+    return n;
+}
+
+/* ============================================================================
+   DESIGNATION DICTIONARY
+   ============================================================================ */
+
+/* Each distinct designation (ignoring case) is interned once and gets a
+   small integer code, the index of its entry. Every entry keeps the IDs of
+   the employees holding it, so a designation query or delete reads only
+   those employees. There are few designations, so lookup is a linear scan
+   of the dictionary rather than of the employees. */
+typedef struct {
+    char name[MAX_DESIGN];
+    KeyList ids;
+} Designation;
+
+typedef struct {
+    Designation *codes;
+    int count, cap;
+} DesigDict;
+
+/* Code of a designation, or -1 if it was never interned */
+static int desig_code(const DesigDict *d, const char *name) {
+    for (int c = 0; c < d->count; ++c)
+        if (strcasecmp(d->codes[c].name, name) == 0) return c;
+    return -1;
+}
+
+static int desig_intern(DesigDict *d, const char *name) {
+    int c = desig_code(d, name);
+    if (c >= 0) return c;
+    if (d->count == d->cap) {
+        int cap = d->cap ? d->cap * 2 : 8;
+        Designation *codes = realloc(d->codes, cap * sizeof(Designation));
+        if (!codes) return -1;
+        d->codes = codes;
+        d->cap = cap;
+    }
+    c = d->count++;
+    snprintf(d->codes[c].name, MAX_DESIGN, "%s", name);
+    memset(&d->codes[c].ids, 0, sizeof(KeyList));
+    return c;
+}
+
+static int desig_add(DesigDict *d, const char *name, int id) {
+    int c = desig_intern(d, name);
+    return c < 0 ? -1 : klist_push(&d->codes[c].ids, id);
+}
+
+/* Searched from the end: bulk deletes remove IDs in reverse file order,
+   which makes each removal O(1) */
+static void desig_remove(DesigDict *d, const char *name, int id) {
+    int c = desig_code(d, name);
+    if (c < 0) return;
+    KeyList *l = &d->codes[c].ids;
+    for (int k = l->count - 1; k >= 0; --k) {
+        if (l->keys[k] != id) continue;
+        l->keys[k] = l->keys[--l->count];
+        return;
+    }
+}
+
+static void desig_free(DesigDict *d) {
+    for (int c = 0; c < d->count; ++c) free(d->codes[c].ids.keys);
+    free(d->codes);
+    memset(d, 0, sizeof(*d));
+}
+
+/* ============================================================================
+   SNAPSHOTS
+   ============================================================================ */
+
+/* Point-in-time reads of customer balances while postings go on. Opening a
+   snapshot only bumps an epoch. Balances are versioned in pages of
+   SNAP_PAGE records: the first change to a page after a snapshot opened
+   saves the page as it was, tagged with that snapshot's epoch, before the
+   balance is overwritten (copy on write). A snapshot with epoch e reads a
+   page from the oldest version tagged e or later, or from the table if the
+   page has not changed since e. When a snapshot closes, versions no open
+   snapshot can reach are freed.
+   Only balances are versioned; the record set and text fields must not
+   change while a snapshot is open. Calls must be serialized by the caller
+   (the store holds store_balance_lock). */
+#define SNAP_PAGE 1024
+
+typedef struct BalVersion {
+    uint64_t epoch;
+    struct BalVersion *next;    /* older version of the same page */
+    long balance[SNAP_PAGE];
+} BalVersion;
+
+typedef struct Snapshot {
+    uint64_t epoch;
+    int count;                  /* records visible to the snapshot */
+    int torn;                   /* a page could not be saved for it */
+    struct Snapshot *next;      /* next older open snapshot */
+} Snapshot;
+
+typedef struct {
+    BalVersion **pages;         /* newest version first, by page */
+    int npages;
+    Snapshot *open;             /* newest first */
+    uint64_t epoch;
+} SnapSet;
+
+static void snap_begin(SnapSet *s, Snapshot *snap, int count) {
+    snap->epoch = ++s->epoch;
+    snap->count = count;
+    snap->torn = 0;
+    snap->next = s->open;
+    s->open = snap;
+}
+
+/* Called before the balance of record i changes */
+static void snap_save(SnapSet *s, const CustTable *t, int i) {
+    if (!s->open) return;
+    int p = i / SNAP_PAGE;
+    if (p < s->npages && s->pages[p] && s->pages[p]->epoch >= s->open->epoch) return;
+    BalVersion *v = malloc(sizeof(BalVersion));
+    if (v && p >= s->npages) {
+        int n = (t->count + SNAP_PAGE - 1) / SNAP_PAGE;
+        BalVersion **grown = realloc(s->pages, n * sizeof(BalVersion *));
+        if (grown) {
+            memset(grown + s->npages, 0, (n - s->npages) * sizeof(BalVersion *));
+            s->pages = grown;
+            s->npages = n;
+        }
+    }
+    if (!v || p >= s->npages) {
+        for (Snapshot *snap = s->open; snap; snap = snap->next) snap->torn = 1;
+        free(v);
+        return;
+    }
+    int first = p * SNAP_PAGE, n = t->count - first < SNAP_PAGE ? t->count - first : SNAP_PAGE;
+    for (int k = 0; k < n; ++k) v->balance[k] = t->hot[first + k].balance;
+    v->epoch = s->open->epoch;
+    v->next = s->pages[p];
+    s->pages[p] = v;
+}
+
+/* Balances of records first..first+n-1 as of snap, all within one page */
+static void snap_read(const SnapSet *s, const CustTable *t, const Snapshot *snap, int first, int n, long *out) {
+    int p = first / SNAP_PAGE;
+    const BalVersion *use = NULL;
+    for (const BalVersion *v = p < s->npages ? s->pages[p] : NULL; v && v->epoch >= snap->epoch; v = v->next)
+        use = v;
+    for (int k = 0; k < n; ++k)
+        out[k] = use ? use->balance[first % SNAP_PAGE + k] : t->hot[first + k].balance;
+}
+
+/* Close snap and free the versions only older snapshots could have read.
+   Returns -1 if the snapshot was torn. */
+static int snap_end(SnapSet *s, Snapshot *snap) {
+    Snapshot **link = &s->open;
+    while (*link && *link != snap) link = &(*link)->next;
+    if (*link) *link = snap->next;
+    uint64_t oldest = UINT64_MAX;
+    for (const Snapshot *o = s->open; o; o = o->next) oldest = o->epoch;
+    for (int p = 0; p < s->npages; ++p) {
+        BalVersion **v = &s->pages[p];
+        while (*v && (*v)->epoch >= oldest) v = &(*v)->next;
+        while (*v) {
+            BalVersion *old = *v;
+            *v = old->next;
+            free(old);
+        }
+    }
+    return snap->torn ? -1 : 0;
+}
+
+/* Saved page versions still held, for checks */
+static long snap_versions(const SnapSet *s) {
+    long n = 0;
+    for (int p = 0; p < s->npages; ++p) {
+        for (const BalVersion *v = s->pages[p]; v; v = v->next) n++;
+    }
+    return n;
+}
+
+static void snap_free(SnapSet *s) {
+    for (int p = 0; p < s->npages; ++p) {
+        while (s->pages[p]) {
+            BalVersion *v = s->pages[p];
+            s->pages[p] = v->next;
+            free(v);
+        }
+    }
+    free(s->pages);
+    memset(s, 0, sizeof(*s));
+}
+
+/* ============================================================================
+   IN-MEMORY STORE
+   ============================================================================ */
+
+/* Both tables are loaded once at startup and every menu operation reads and
+   mutates them in place. With the text backend a table is only written back
+   at an explicit flush point (store_flush), and only if something marked it
+   dirty. With the binary backend each change is stored straight into the
+   mapped record and a flush just syncs the mappings. */
+typedef struct {
+    Employee *emps;
+    int emp_count, emp_cap;
+    CustTable cust;
+    HashIndex emp_by_id;
+    DesigDict emp_by_desig;
+    BalanceIndex emp_by_salary;     /* (salary, ID) nodes */
+    HashIndex by_account, by_aadhaar, by_phone;
+    BalanceIndex by_balance;
+    SnapSet snaps;              /* open SNAPSHOTS and saved balance pages */
+    NameIndex emp_names, cust_names;
+    int names_ready;            /* NAME INDEX is built on first use */
+    int emps_dirty, custs_dirty;
+    unsigned char shard_dirty[SHARD_MAX];   /* CUSTOMER SHARDS behind memory */
+    int emp_dead, cust_dead;    /* deleted records still in the text files */
+    int journal_fd;
+    uint64_t journal_seq;       /* last sequence number found on replay */
+    int journal_records;        /* postings since the last checkpoint */
+    int checkpoint_due;         /* journal_records reached JOURNAL_CHECKPOINT_EVERY */
+    GroupCommit gc;             /* durability of store_post */
+    ChangeFeed feed;            /* CHANGE FEED of customer mutations */
+    int binary;                 /* 1 = BINARY STORAGE backend */
+    BinFile emp_bin, cust_bin;
+    int lock_fd;                /* holds an exclusive flock on LOCK_FILE */
+    int next_emp_id, next_account;  /* ID SEQUENCES */
+} Store;
+
+static Store store;
+
+/* Serializes journal appends, in-memory balance updates of the text backend
+   and checkpoints, so a checkpoint never misses a journaled posting */
+static pthread_mutex_t store_post_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Guards by_balance and snaps, which postings to different accounts update
+   concurrently */
+static pthread_mutex_t store_balance_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The shard holding account must be rewritten at the next checkpoint */
+static void store_shard_dirty(int account) {
+    store.shard_dirty[shard_of(&cust_shards, account)] = 1;
+}
+
+/* Every balance change of a loaded customer goes through here so the
+   BALANCE INDEX follows it */
+static void store_set_balance(int i, long balance) {
+    CustHot *c = &store.cust.hot[i];
+    pthread_mutex_lock(&store_balance_lock);
+    snap_save(&store.snaps, &store.cust, i);
+    bidx_remove(&store.by_balance, c->balance, c->account);
+    c->balance = balance;
+    bidx_insert(&store.by_balance, c->balance, c->account);
+    pthread_mutex_unlock(&store_balance_lock);
+}
+
+/* Open a point-in-time view of the customer balances (see SNAPSHOTS).
+   Postings go on meanwhile; records must not be added, removed or edited
+   until store_snapshot_end. */
+void store_snapshot_begin(Snapshot *snap) {
+    pthread_mutex_lock(&store_balance_lock);
+    snap_begin(&store.snaps, snap, store.cust.count);
+    pthread_mutex_unlock(&store_balance_lock);
+}
+
+/* Balances of records first..first+n-1 as of snap. The lock is taken once
+   per page, so postings are held up for one page copy at most. */
+void store_snapshot_balances(const Snapshot *snap, int first, int n, long *out) {
+    while (n > 0) {
+        int k = SNAP_PAGE - first % SNAP_PAGE;
+        if (k > n) k = n;
+        pthread_mutex_lock(&store_balance_lock);
+        snap_read(&store.snaps, &store.cust, snap, first, k, out);
+        pthread_mutex_unlock(&store_balance_lock);
+        first += k;
+        out += k;
+        n -= k;
+    }
+}
+
+/* Returns -1 if pages could not be saved, so the view was not consistent */
+int store_snapshot_end(Snapshot *snap) {
+    pthread_mutex_lock(&store_balance_lock);
+    int rc = snap_end(&store.snaps, snap);
+    pthread_mutex_unlock(&store_balance_lock);
+    return rc;
+}
+
+/* Rebuild all customer indexes from scratch, e.g. after records moved.
+   When a file holds duplicate keys the first record wins, matching the
+   first-match behaviour of a linear scan. */
+static int store_reindex_customers(void) {
+    ct_maybe_compact(&store.cust);
+    hidx_free(&store.by_account);
+    hidx_free(&store.by_aadhaar);
+    hidx_free(&store.by_phone);
+    if (hidx_init(&store.by_account, KEY_ACCOUNT, store.cust.count) != 0 ||
+        hidx_init(&store.by_aadhaar, KEY_AADHAAR, store.cust.count) != 0 ||
+        hidx_init(&store.by_phone, KEY_PHONE, store.cust.count) != 0) return -1;
+    for (int i = 0; i < store.cust.count; ++i) {
+        hidx_insert(&store.by_account, &store.cust, i);
+        hidx_insert(&store.by_aadhaar, &store.cust, i);
+        hidx_insert(&store.by_phone, &store.cust, i);
+    }
+    return 0;
+}
+
+static int store_reindex_employees(void) {
+    hidx_free(&store.emp_by_id);
+    if (hidx_init(&store.emp_by_id, KEY_EMP_ID, store.emp_count) != 0) return -1;
+    for (int i = 0; i < store.emp_count; ++i) hidx_insert(&store.emp_by_id, store.emps, i);
+    return 0;
+}
+
+/* Designation and salary indexes are keyed by employee ID, so unlike
+   emp_by_id they survive records moving and are maintained per change */
+static void store_free_employee_fields(void) {
+    desig_free(&store.emp_by_desig);
+    bidx_free(&store.emp_by_salary);
+}
+
+static int store_index_employee_fields(void) {
+    store_free_employee_fields();
+    BalanceKey *keys = malloc((store.emp_count ? store.emp_count : 1) * sizeof(BalanceKey));
+    if (!keys) return -1;
+    for (int i = 0; i < store.emp_count; ++i) {
+        if (desig_add(&store.emp_by_desig, store.emps[i].designation, store.emps[i].id) != 0) {
+            free(keys);
+            return -1;
+        }
+        keys[i].balance = atol(store.emps[i].salary);
+        keys[i].account = store.emps[i].id;
+    }
+    return bidx_build_keys(&store.emp_by_salary, keys, store.emp_count);
+}
+
+/* No-ops while the indexes are freed (store_free_employee_fields) */
+static int store_index_employee(const Employee *e) {
+    if (!store.emp_by_salary.head) return 0;
+    if (desig_add(&store.emp_by_desig, e->designation, e->id) != 0) return -1;
+    return bidx_insert(&store.emp_by_salary, atol(e->salary), e->id);
+}
+
+static void store_unindex_employee(const Employee *e) {
+    if (!store.emp_by_salary.head) return;
+    desig_remove(&store.emp_by_desig, e->designation, e->id);
+    bidx_remove(&store.emp_by_salary, atol(e->salary), e->id);
+}
+
+/* Rewrite the CHANGE FEED lines of journal records that were durable when
+   the process stopped but whose lines were not (the journal is synced
+   first). The feed must be open. */
+static int store_backfill_feed(const JournalRecord *recs, int n) {
+    int k = 0;
+    while (k < n && recs[k].change <= store.feed.last_seq) k++;
+    int m = n - k;
+    if (m <= 0) return 0;
+    Change *lines = malloc((size_t)m * sizeof(Change));
+    if (!lines) return -1;
+    for (int j = 0; j < m; ++j) {
+        const JournalRecord *r = &recs[k + j];
+        lines[j] = (Change){ r->change, change_op(r->kind, r->amount), r->account,
+                             r->balance - r->amount, r->balance, NULL };
+    }
+    int rc = feed_write(&store.feed, lines, m) == m ? 0 : -1;
+    free(lines);
+    return rc;
+}
+
+/* Apply journal postings on top of the customers.txt snapshot */
+static int store_replay_journal(void) {
+    JournalRecord *recs = NULL; int n = 0;
+    if (journal_read(&recs, &n) != 0) return -1;
+    if (store_backfill_feed(recs, n) != 0) { free(recs); return -1; }
+    char *dead = NULL;
+    store.cust_dead = 0;
+    for (int k = 0; k < n; ++k) {
+        int i = hidx_find(&store.by_account, &store.cust, &recs[k].account);
+        if (i < 0) continue;
+        store_shard_dirty(recs[k].account);
+        if (recs[k].kind == JOURNAL_DELETE) {
+            if (!dead && !(dead = calloc(store.cust.count, 1))) { free(recs); return -1; }
+            dead[i] = 1;
+            hidx_remove(&store.by_account, &store.cust, i);
+            store.cust_dead++;
+        } else {
+            store.cust.hot[i].balance = recs[k].balance;
+        }
+    }
+    if (dead) {
+        int live = 0;
+        for (int i = 0; i < store.cust.count; ++i) {
+            if (dead[i]) ct_release(&store.cust, i);
+            else store.cust.hot[live++] = store.cust.hot[i];
+        }
+        store.cust.count = live;
+        free(dead);
+        if (store_reindex_customers() != 0) { free(recs); return -1; }
+    }
+    store.journal_seq = n ? recs[n-1].seq : 0;
+    store.journal_records = n;
+    free(recs);
+    return 0;
+}
+
+/* Drop employees deleted since employees.txt was last written */
+static int store_apply_employee_tombstones(void) {
+    int *ids, n;
+    if (load_employee_tombstones(&ids, &n) != 0) return -1;
+    store.emp_dead = 0;
+    if (n == 0) return 0;
+    qsort(ids, n, sizeof(int), cmp_int);
+    int live = 0;
+    for (int i = 0; i < store.emp_count; ++i) {
+        if (bsearch(&store.emps[i].id, ids, n, sizeof(int), cmp_int)) store.emp_dead++;
+        else store.emps[live++] = store.emps[i];
+    }
+    store.emp_count = live;
+    free(ids);
+    return 0;
+}
+
+static int store_load_binary(void) {
+    if (bin_open(&store.emp_bin, EMP_BIN, "BNKEMP01", sizeof(BinEmployee)) != 0) return -1;
+    if (bin_open(&store.cust_bin, CUST_BIN, "BNKCUS01", sizeof(BinCustomer)) != 0) return -1;
+    if (bin_load_employees(&store.emp_bin, &store.emps, &store.emp_count) != 0) return -1;
+    if (bin_load_customers(&store.cust_bin, &store.cust) != 0) return -1;
+    return 0;
+}
+
+/* Only one process may own the data files at a time; a second instance
+   would otherwise overwrite the first one's saves */
+static int store_lock_files(void) {
+    store.lock_fd = open(LOCK_FILE, O_RDWR | O_CREAT, 0644);
+    if (store.lock_fd < 0) return -1;
+    if (flock(store.lock_fd, LOCK_EX | LOCK_NB) != 0) {
+        fprintf(stderr, "Data files are in use by another banking process\n");
+        close(store.lock_fd);
+        store.lock_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+/* The sequences never fall behind the loaded records, e.g. for data
+   written before META_FILE existed or a record appended just before a
+   crash. A missing file is created so the next run starts from it. */
+static int store_load_sequences(void) {
+    int missing = meta_load(&store.next_emp_id, &store.next_account) != 0;
+    int emp = store.next_emp_id, acc = store.next_account;
+    for (int i = 0; i < store.emp_count; ++i)
+        if (store.emps[i].id >= emp) emp = store.emps[i].id + 1;
+    for (int i = 0; i < store.cust.count; ++i)
+        if (store.cust.hot[i].account >= acc) acc = store.cust.hot[i].account + 1;
+    if (!missing && emp == store.next_emp_id && acc == store.next_account) return 0;
+    store.next_emp_id = emp;
+    store.next_account = acc;
+    return meta_save(emp, acc);
+}
+
+int store_load(void) {
+    store.journal_fd = -1;
+    store.feed.fd = -1;
+    if (store_lock_files() != 0) return -1;
+    store.binary = access(CUST_BIN, F_OK) == 0;
+    if (store.binary) {
+        if (store_load_binary() != 0) return -1;
+    } else {
+        if (load_employees(&store.emps, &store.emp_count) != 0) return -1;
+        if (store_apply_employee_tombstones() != 0) return -1;
+        if (load_customers(&store.cust) != 0) return -1;
+    }
+    store.emp_cap = store.emp_count;
+    store.emps_dirty = store.custs_dirty = 0;
+    memset(store.shard_dirty, 0, sizeof(store.shard_dirty));
+    if (store_reindex_employees() != 0) return -1;
+    if (store_index_employee_fields() != 0) return -1;
+    if (store_reindex_customers() != 0) return -1;
+    if (store_load_sequences() != 0) return -1;
+    if (feed_open(&store.feed) != 0) return -1;
+    if (!store.binary) {
+        if (store_replay_journal() != 0) return -1;
+        store.journal_fd = journal_open();
+        if (store.journal_fd < 0) return -1;
+    }
+    if (bidx_build(&store.by_balance, &store.cust) != 0) return -1;
+    if (store.binary) return gc_start(&store.gc, -1, &store.cust_bin, &store.feed, 0);
+    return gc_start(&store.gc, store.journal_fd, NULL, &store.feed, store.journal_seq);
+}
+
+/* Fold all journaled postings into a fresh snapshot and empty the journal.
+   Only shards with changes since the last checkpoint are rewritten. */
+int store_checkpoint(void) {
+    if (store.binary) {
+        if (bin_sync(&store.cust_bin) != 0) return -1;
+        store.checkpoint_due = 0;
+        return 0;
+    }
+    if (gc_drain(&store.gc) != 0) return -1;
+    if (save_customer_shards(&store.cust, &cust_shards, store.shard_dirty) != 0) return -1;
+    memset(store.shard_dirty, 0, sizeof(store.shard_dirty));
+    store.custs_dirty = 0;
+    if (journal_reset(store.journal_fd) != 0) return -1;
+    store.journal_records = 0;
+    store.checkpoint_due = 0;
+    store.cust_dead = 0;
+    return 0;
+}
+
+/* Postings only flag the checkpoint (they may run on the server loop or
+   under store_post_lock); the callers that may block run it from here at
+   their next quiet moment. 0 when none is due. */
+int store_checkpoint_if_due(void) {
+    if (!store.checkpoint_due) return 0;
+    pthread_mutex_lock(&store_post_lock);
+    int rc = store_checkpoint();
+    pthread_mutex_unlock(&store_post_lock);
+    return rc;
+}
+
+/* Have the next store_checkpoint_if_due write back a change the journal
+   does not carry (a text field, or anything in the binary tables) */
+void store_checkpoint_soon(void) {
+    pthread_mutex_lock(&store_post_lock);
+    store.checkpoint_due = 1;
+    pthread_mutex_unlock(&store_post_lock);
+}
+
+/* Deleted records are left in a text file as tombstones until they make
+   up COMPACT_DEAD_PERCENT of it */
+static int store_compact_due(int dead, int live) {
+    return dead > 0 && (long)dead * 100 > (long)live * COMPACT_DEAD_PERCENT;
+}
+
+/* Write back every table that changed since the last flush, and every
+   table holding enough tombstones to be worth compacting */
+int store_flush(void) {
+    uint64_t t0 = metric_now();
+    int rc = 0;
+    if (store.binary) {
+        if (bin_sync(&store.emp_bin) != 0 || bin_sync(&store.cust_bin) != 0) rc = -1;
+        store.emps_dirty = store.custs_dirty = 0;
+        metric_record(M_FLUSH, t0, 0, 0);
+        return rc;
+    }
+    if (store.emps_dirty || store_compact_due(store.emp_dead, store.emp_count)) {
+        if (save_employees(store.emps, store.emp_count) != 0) {
+            rc = -1;
+        } else {
+            remove(EMP_TOMBSTONES);
+            store.emps_dirty = 0;
+            store.emp_dead = 0;
+        }
+    }
+    if (store.custs_dirty || store.checkpoint_due || store_compact_due(store.cust_dead, store.cust.count)) {
+        if (store_checkpoint() != 0) rc = -1;
+    } else if (gc_drain(&store.gc) != 0) {
+        rc = -1;            /* tombstones not yet durable */
+    }
+    metric_record(M_FLUSH, t0, 0, 0);
+    return rc;
+}
+
+/* Apply a posting in memory and queue it for the next commit batch.
+   Returns its sequence number, 0 if it could not be queued. */
+uint64_t store_post_enqueue(int i, long amount) {
+    CustHot *c = &store.cust.hot[i];
+    uint64_t seq = 0;
+    if (store.binary) {
+        if (bin_set_balance(&store.cust_bin, c->account, c->balance + amount) == 0) {
+            store_set_balance(i, c->balance + amount);
+            seq = gc_enqueue(&store.gc, JOURNAL_POST, c->account, amount, c->balance);
+        }
+    } else {
+        pthread_mutex_lock(&store_post_lock);
+        seq = gc_enqueue(&store.gc, JOURNAL_POST, c->account, amount, c->balance + amount);
+        if (seq) {
+            store_set_balance(i, c->balance + amount);
+            store_shard_dirty(c->account);
+            if (++store.journal_records >= JOURNAL_CHECKPOINT_EVERY) store.checkpoint_due = 1;
+        }
+        pthread_mutex_unlock(&store_post_lock);
+    }
+    return seq;
+}
+
+/* Deposit (amount > 0) or withdraw (amount < 0) on record i. Only the
+   journal is written; customers.txt is refreshed at the next checkpoint.
+   Returns once the posting is durable. */
+int store_post(int i, long amount) {
+    uint64_t t0 = metric_now();
+    gc_begin(&store.gc);
+    int rc = gc_wait(&store.gc, store_post_enqueue(i, amount));
+    metric_record(M_POST, t0, 0, 0);
+    return rc;
+}
+
+/* Put a CREATE or UPDATE of record i, with its text fields, on the CHANGE FEED */
+static int store_change_record(int op, int i, long before) {
+    const CustTable *t = &store.cust;
+    char image[MAX_LINE];
+    snprintf(image, sizeof(image), "%s|%s|%s|%s", ct_str(t, i, CF_NAME), ct_str(t, i, CF_AADHAAR),
+             ct_str(t, i, CF_PHONE), ct_str(t, i, CF_ADDRESS));
+    return gc_change(&store.gc, op, t->hot[i].account, before, t->hot[i].balance, image);
+}
+
+/* Record i was modified in memory (text fields or balance overwrite);
+   before is the customer's balance ahead of the change, for the feed */
+void store_employee_changed(int i) {
+    if (store.binary) bin_put_employee(&store.emp_bin, &store.emps[i]);
+    else store.emps_dirty = 1;
+}
+
+void store_customer_changed(int i, long before) {
+    if (store.binary) {
+        Customer c;
+        ct_get(&store.cust, i, &c);
+        bin_put_customer(&store.cust_bin, &c);
+    } else {
+        store.custs_dirty = 1;
+        store_shard_dirty(store.cust.hot[i].account);
+    }
+    store_change_record(CHANGE_UPDATE, i, before);
+    ct_maybe_compact(&store.cust);
+}
+
+/* Record is about to be dropped from its in-memory table. With the text
+   backend only tombstones are written (O(1) I/O per record), by
+   store_employees_removed once per delete; store_flush compacts the file
+   once tombstones pile up. */
+void store_employee_removed(const Employee *e) {
+    if (store.names_ready) nidx_remove(&store.emp_names, e->name, e->id);
+    store_unindex_employee(e);
+    if (store.binary) bin_clear(&store.emp_bin, e->id);
+}
+
+/* Tombstone the n employees just passed to store_employee_removed. If that
+   fails (or ids is NULL for want of memory) employees.txt is rewritten at
+   the next store_flush instead. */
+void store_employees_removed(const int *ids, int n) {
+    if (store.binary || n == 0) return;
+    if (ids && append_employee_tombstones(ids, n) == 0) store.emp_dead += n;
+    else store.emps_dirty = 1;
+}
+
+void store_customer_removed(int i) {
+    int account = store.cust.hot[i].account;
+    long balance = store.cust.hot[i].balance;
+    pthread_mutex_lock(&store_balance_lock);
+    bidx_remove(&store.by_balance, balance, account);
+    pthread_mutex_unlock(&store_balance_lock);
+    if (store.names_ready) nidx_remove(&store.cust_names, ct_str(&store.cust, i, CF_NAME), account);
+    ct_release(&store.cust, i);
+    if (store.binary) {
+        bin_clear(&store.cust_bin, account);
+        gc_change(&store.gc, CHANGE_DELETE, account, balance, 0, NULL);
+        return;
+    }
+    pthread_mutex_lock(&store_post_lock);
+    store_shard_dirty(account);
+    if (gc_enqueue(&store.gc, JOURNAL_DELETE, account, -balance, 0) != 0) {
+        store.cust_dead++;
+        if (++store.journal_records >= JOURNAL_CHECKPOINT_EVERY) store.checkpoint_due = 1;
+    } else {
+        store.custs_dirty = 1;
+    }
+    pthread_mutex_unlock(&store_post_lock);
+}
+
+/* Like store_post, but nothing reaches disk until the next store_flush.
+   Used by bulk operations that persist once at the end. */
+int store_post_deferred(int i, long amount) {
+    CustHot *c = &store.cust.hot[i];
+    if (store.binary) return store_post(i, amount);
+    pthread_mutex_lock(&store_post_lock);
+    long before = c->balance;
+    store_set_balance(i, c->balance + amount);
+    store.custs_dirty = 1;
+    store_shard_dirty(c->account);
+    int rc = gc_change(&store.gc, amount < 0 ? CHANGE_WITHDRAW : CHANGE_DEPOSIT, c->account, before, c->balance, NULL);
+    pthread_mutex_unlock(&store_post_lock);
+    return rc;
+}
+
+void store_free(void) {
+    gc_stop(&store.gc);
+    feed_close(&store.feed);
+    if (store.journal_fd >= 0) close(store.journal_fd);
+    if (store.lock_fd >= 0) close(store.lock_fd);
+    bin_close(&store.emp_bin);
+    bin_close(&store.cust_bin);
+    free(store.emps);
+    ct_free(&store.cust);
+    hidx_free(&store.emp_by_id);
+    store_free_employee_fields();
+    hidx_free(&store.by_account);
+    hidx_free(&store.by_aadhaar);
+    hidx_free(&store.by_phone);
+    bidx_free(&store.by_balance);
+    snap_free(&store.snaps);
+    nidx_free(&store.emp_names);
+    nidx_free(&store.cust_names);
+    memset(&store, 0, sizeof(store));
+    store.journal_fd = store.lock_fd = -1;
+}
+
+static int store_find_employee(int id) {
+    return hidx_find(&store.emp_by_id, store.emps, &id);
+}
+
+static int store_find_customer(int acc) {
+    return hidx_find(&store.by_account, &store.cust, &acc);
+}
+
+static int store_find_aadhaar(const char *aadhaar) {
+    return hidx_find(&store.by_aadhaar, &store.cust, aadhaar);
+}
+
+static int store_find_phone(const char *phone) {
+    return hidx_find(&store.by_phone, &store.cust, phone);
+}
+
+/* Positions of the customers with lo <= balance <= hi, highest balance
+   first, at most max of them; *out is malloc'd. Returns the count or -1. */
+static int store_find_balances(long lo, long hi, int max, int **out) {
+    pthread_mutex_lock(&store_balance_lock);
+    int n = bidx_collect(&store.by_balance, lo, hi, max, out);
+    pthread_mutex_unlock(&store_balance_lock);
+    for (int k = 0; k < n; ++k) (*out)[k] = store_find_customer((*out)[k]);
+    return n;
+}
+
+static const char *store_employee_name(int id) {
+    int i = store_find_employee(id);
+    return i < 0 ? NULL : store.emps[i].name;
+}
+
+static const char *store_customer_name(int account) {
+    int i = store_find_customer(account);
+    return i < 0 ? NULL : ct_str(&store.cust, i, CF_NAME);
+}
+
+/* Drop the name indexes, e.g. before deleting a whole table; the next
+   name search rebuilds them */
+static void store_drop_names(void) {
+    nidx_free(&store.emp_names);
+    nidx_free(&store.cust_names);
+    store.names_ready = 0;
+}
+
+static int store_build_names(void) {
+    if (store.names_ready) return 0;
+    if (nidx_init(&store.emp_names) != 0 || nidx_init(&store.cust_names) != 0) goto fail;
+    for (int i = 0; i < store.emp_count; ++i)
+        if (nidx_add(&store.emp_names, store.emps[i].name, store.emps[i].id) != 0) goto fail;
+    for (int i = 0; i < store.cust.count; ++i)
+        if (nidx_add(&store.cust_names, ct_str(&store.cust, i, CF_NAME), store.cust.hot[i].account) != 0)
+            goto fail;
+    store.names_ready = 1;
+    return 0;
+fail:
+    store_drop_names();
+    return -1;
+}
+
+/* Map keys from the NAME INDEX to table positions in place */
+static int store_name_positions(int employees, int *keys, int n) {
+    int k = 0;
+    for (int j = 0; j < n; ++j) {
+        int i = employees ? store_find_employee(keys[j]) : store_find_customer(keys[j]);
+        if (i >= 0) keys[k++] = i;
+    }
+    return k;
+}
+
+/* Positions of the records whose name starts with prefix (ignoring case),
+   in name order; *out is malloc'd. Returns the count or -1. */
+static int store_find_name_prefix(int employees, const char *prefix, int **out) {
+    *out = NULL;
+    if (store_build_names() != 0) return -1;
+    int n = nidx_prefix(employees ? &store.emp_names : &store.cust_names, prefix, out);
+    return n < 0 ? n : store_name_positions(employees, *out, n);
+}
+
+/* Positions of the records whose name is closest to name, nearest first */
+static int store_find_name_similar(int employees, const char *name, int **out) {
+    *out = NULL;
+    if (store_build_names() != 0) return -1;
+    int n = employees ? nidx_fuzzy(&store.emp_names, name, store_employee_name, NAME_FUZZY_MAX, out)
+                      : nidx_fuzzy(&store.cust_names, name, store_customer_name, NAME_FUZZY_MAX, out);
+    return n < 0 ? n : store_name_positions(employees, *out, n);
+}
+
+/* Positions of the employees holding a designation (ignoring case), in
+   file order; *out is malloc'd. Returns the count or -1. */
+static int store_find_designation(const char *designation, int **out) {
+    int c = desig_code(&store.emp_by_desig, designation);
+    const KeyList *ids = c >= 0 ? &store.emp_by_desig.codes[c].ids : NULL;
+    int n = ids ? ids->count : 0;
+    *out = malloc((n ? n : 1) * sizeof(int));
+    if (!*out) return -1;
+    for (int k = 0; k < n; ++k) (*out)[k] = store_find_employee(ids->keys[k]);
+    qsort(*out, n, sizeof(int), cmp_int);
+    return n;
+}
+
+/* Positions of the employees with lo <= salary <= hi, highest first */
+static int store_find_salaries(long lo, long hi, int **out) {
+    int n = bidx_collect(&store.emp_by_salary, lo, hi, INT_MAX, out);
+    for (int k = 0; k < n; ++k) (*out)[k] = store_find_employee((*out)[k]);
+    return n;
+}
+
+/* Drop the employees at the given ascending positions and close the gaps */
+static int store_remove_employees(const int *pos, int n) {
+    if (n == 0) return 0;
+    int *ids = malloc(n * sizeof(int));
+    for (int k = n - 1; k >= 0; --k) {
+        if (ids) ids[k] = store.emps[pos[k]].id;
+        store_employee_removed(&store.emps[pos[k]]);
+    }
+    store_employees_removed(ids, n);
+    free(ids);
+    int live = pos[0];
+    for (int k = 0; k < n; ++k) {
+        int from = pos[k] + 1, to = k + 1 < n ? pos[k+1] : store.emp_count;
+        memmove(&store.emps[live], &store.emps[from], (to - from) * sizeof(Employee));
+        live += to - from;
+    }
+    store.emp_count = live;
+    return store_reindex_employees();
+}
+
+static int store_remove_customers(const int *pos, int n) {
+    if (n == 0) return 0;
+    for (int k = n - 1; k >= 0; --k) store_customer_removed(pos[k]);
+    CustHot *hot = store.cust.hot;
+    int live = pos[0];
+    for (int k = 0; k < n; ++k) {
+        int from = pos[k] + 1, to = k + 1 < n ? pos[k+1] : store.cust.count;
+        memmove(&hot[live], &hot[from], (to - from) * sizeof(CustHot));
+        live += to - from;
+    }
+    store.cust.count = live;
+    return store_reindex_customers();
+}
+
+void store_set_employee_salary(int i, const char *salary) {
+    store_unindex_employee(&store.emps[i]);
+    strcpy(store.emps[i].salary, salary);
+    store_index_employee(&store.emps[i]);
+}
+
+void store_set_employee_designation(int i, const char *designation) {
+    store_unindex_employee(&store.emps[i]);
+    strcpy(store.emps[i].designation, designation);
+    store_index_employee(&store.emps[i]);
+}
+
+/* Rename record i, keeping the NAME INDEX in sync */
+void store_set_employee_name(int i, const char *name) {
+    if (store.names_ready) nidx_remove(&store.emp_names, store.emps[i].name, store.emps[i].id);
+    strcpy(store.emps[i].name, name);
+    if (store.names_ready && nidx_add(&store.emp_names, name, store.emps[i].id) != 0) store_drop_names();
+}
+
+int store_set_customer_name(int i, const char *name) {
+    int account = store.cust.hot[i].account;
+    if (store.names_ready) nidx_remove(&store.cust_names, ct_str(&store.cust, i, CF_NAME), account);
+    int rc = ct_set(&store.cust, i, CF_NAME, name);
+    if (store.names_ready && nidx_add(&store.cust_names, ct_str(&store.cust, i, CF_NAME), account) != 0)
+        store_drop_names();
+    return rc;
+}
+
+/* Replace the aadhaar of record i, keeping the index in sync.
+   Returns -1 if another customer already holds that aadhaar. */
+int store_set_customer_aadhaar(int i, const char *aadhaar) {
+    int other = store_find_aadhaar(aadhaar);
+    if (other >= 0 && other != i) return -1;
+    hidx_remove(&store.by_aadhaar, &store.cust, i);
+    int rc = ct_set(&store.cust, i, CF_AADHAAR, aadhaar);
+    hidx_insert(&store.by_aadhaar, &store.cust, i);
+    return rc;
+}
+
+int store_set_customer_phone(int i, const char *phone) {
+    int other = store_find_phone(phone);
+    if (other >= 0 && other != i) return -1;
+    hidx_remove(&store.by_phone, &store.cust, i);
+    int rc = ct_set(&store.cust, i, CF_PHONE, phone);
+    hidx_insert(&store.by_phone, &store.cust, i);
+    return rc;
+}
+
+static int store_next_employee_id(void) {
+    return store.next_emp_id;
+}
+
+static int store_next_account(void) {
+    return store.next_account;
+}
+
+/* Move a sequence past a key that is about to be used. META_FILE is written
+   before the record, so a crash can skip a number but never reuse one. */
+static int store_claim_key(int *next, int key) {
+    if (key < *next) return 0;
+    *next = key + 1;
+    return meta_save(store.next_emp_id, store.next_account);
+}
+
+/* Put a record into the in-memory table and its indexes */
+static int store_insert_employee(const Employee *e) {
+    if (store.emp_count == store.emp_cap) {
+        int cap = store.emp_cap ? store.emp_cap * 2 : 8;
+        Employee *arr = realloc(store.emps, cap * sizeof(Employee));
+        if (!arr) return -1;
+        store.emps = arr;
+        store.emp_cap = cap;
+    }
+    store.emps[store.emp_count++] = *e;
+    hidx_insert(&store.emp_by_id, store.emps, store.emp_count - 1);
+    store_index_employee(e);
+    if (store.names_ready && nidx_add(&store.emp_names, e->name, e->id) != 0) store_drop_names();
+    return 0;
+}
+
+/* Rejects (returns -1) a customer whose account, aadhaar or phone is taken */
+static int store_insert_customer(const Customer *c) {
+    if (store_find_customer(c->account) >= 0 || store_find_aadhaar(c->aadhaar) >= 0 ||
+        store_find_phone(c->phone) >= 0) return -1;
+    if (ct_append(&store.cust, c) != 0) return -1;
+    int pos = store.cust.count - 1;
+    hidx_insert(&store.by_account, &store.cust, pos);
+    hidx_insert(&store.by_aadhaar, &store.cust, pos);
+    hidx_insert(&store.by_phone, &store.cust, pos);
+    pthread_mutex_lock(&store_balance_lock);
+    bidx_insert(&store.by_balance, c->balance, c->account);
+    pthread_mutex_unlock(&store_balance_lock);
+    if (store.names_ready && nidx_add(&store.cust_names, c->name, c->account) != 0) store_drop_names();
+    return 0;
+}
+
+/* New records are appended to the file directly, so no full rewrite is needed */
+int store_add_employee(const Employee *e) {
+    if (store_claim_key(&store.next_emp_id, e->id) != 0) return -1;
+    if (store_insert_employee(e) != 0) return -1;
+    if (store.binary) return bin_put_employee(&store.emp_bin, e);
+    return append_employee(e);
+}
+
+int store_add_customer(const Customer *c) {
+    if (store_find_customer(c->account) >= 0 || store_find_aadhaar(c->aadhaar) >= 0 ||
+        store_find_phone(c->phone) >= 0) return -1;
+    if (store_claim_key(&store.next_account, c->account) != 0) return -1;
+    if (store_insert_customer(c) != 0) return -1;
+    if ((store.binary ? bin_put_customer(&store.cust_bin, c) : append_customer(c)) != 0) return -1;
+    return store_change_record(CHANGE_CREATE, store.cust.count - 1, 0);
+}
+
+/* Bulk imports stage records in memory, taking the next numbers in turn,
+   and then commit them all at once: META_FILE is written once for the
+   whole range, then the records in a single append. Until the commit
+   nothing is on disk, so a failed import is dropped by not flushing. */
+int store_stage_employee(Employee *e) {
+    e->id = store.next_emp_id;
+    if (store_insert_employee(e) != 0) return -1;
+    store.next_emp_id++;
+    return 0;
+}
+
+int store_stage_customer(Customer *c) {
+    c->account = store.next_account;
+    if (store_insert_customer(c) != 0) return -1;
+    store.next_account++;
+    return 0;
+}
+
+/* Persist the records staged since position first of each table */
+int store_commit_staged(int first_emp, int first_cust) {
+    int emps = store.emp_count - first_emp, custs = store.cust.count - first_cust;
+    if (emps == 0 && custs == 0) return 0;
+    if (meta_save(store.next_emp_id, store.next_account) != 0) return -1;
+    if (!store.binary) {
+        if (emps > 0 && append_employees(store.emps + first_emp, emps) != 0) return -1;
+        if (custs > 0 && append_customers(&store.cust, first_cust, custs) != 0) return -1;
+    } else {
+        for (int i = first_emp; i < store.emp_count; ++i)
+            if (bin_put_employee(&store.emp_bin, &store.emps[i]) != 0) return -1;
+        for (int i = first_cust; i < store.cust.count; ++i) {
+            Customer c;
+            ct_get(&store.cust, i, &c);
+            if (bin_put_customer(&store.cust_bin, &c) != 0) return -1;
+        }
+        if (bin_sync(&store.emp_bin) != 0 || bin_sync(&store.cust_bin) != 0) return -1;
+    }
+    for (int i = first_cust; i < store.cust.count; ++i)
+        if (store_change_record(CHANGE_CREATE, i, 0) != 0) return -1;
+    return gc_drain(&store.gc);
+}
+
+/* Cut the customer table into new shard files (see CUSTOMER SHARDS). With
+   shards > 0 the table is split into that many ranges of equal row count,
+   1 meaning the single CUST_FILE; with shards == 0 every shard holding
+   more than max_rows rows is split into equal pieces and the rest are left
+   alone. Only new pieces are written. Text backend only. */
+int store_reshard(int shards, int max_rows) {
+    if (store.binary || shards < 0 || shards > SHARD_MAX || (shards == 0 && max_rows < 1)) return -1;
+    if (store_checkpoint() != 0) return -1;
+    int n = store.cust.count;
+    int *acc = malloc((n ? n : 1) * sizeof(int));
+    if (!acc) return -1;
+    for (int i = 0; i < n; ++i) acc[i] = store.cust.hot[i].account;
+    qsort(acc, n, sizeof(int), cmp_int);
+
+    ShardMap next = { 0 };
+    unsigned char write[SHARD_MAX] = { 0 };
+    int file = shard_next_file(&cust_shards), rc = 0;
+    if (shards == 1) {
+        next.count = 1;
+        next.file[0] = -1;
+        write[0] = 1;
+    } else if (shards > 1) {
+        for (int k = 0; k < shards; ++k) {
+            int first = k == 0 ? 0 : acc[(long)n * k / shards];
+            if (k > 0 && (n == 0 || first <= next.first[next.count-1])) continue;
+            next.first[next.count] = first;
+            next.file[next.count] = file++;
+            write[next.count++] = 1;
+        }
+    } else {
+        /* Rows of shard s are acc[lo..hi) */
+        int lo = 0;
+        for (int s = 0; s < cust_shards.count && rc == 0; ++s) {
+            int hi = lo;
+            while (hi < n && (s == cust_shards.count - 1 || acc[hi] < cust_shards.first[s+1])) hi++;
+            int pieces = (hi - lo + max_rows - 1) / max_rows;
+            if (pieces <= 1) pieces = 1;
+            if (next.count + pieces > SHARD_MAX) { rc = -1; break; }
+            for (int p = 0; p < pieces; ++p) {
+                int first = p == 0 ? cust_shards.first[s] : acc[lo + (long)(hi - lo) * p / pieces];
+                if (p > 0 && first <= next.first[next.count-1]) continue;
+                next.first[next.count] = first;
+                next.file[next.count] = pieces > 1 ? file++ : cust_shards.file[s];
+                write[next.count++] = pieces > 1;
+            }
+            lo = hi;
+        }
+    }
+    free(acc);
+    if (rc != 0 || save_customer_shards(&store.cust, &next, write) != 0 || shard_map_save(&next) != 0) return -1;
+    for (int k = 0; k < cust_shards.count; ++k) {
+        if (shard_map_has(&next, cust_shards.file[k])) continue;
+        char path[SHARD_PATH];
+        shard_path(cust_shards.file[k], path, sizeof(path));
+        remove(path);
+    }
+    cust_shards = next;
+    return next.count;
+}
+
+/* ============================================================================
+   TRANSACTION ENGINE
+   ============================================================================ */
+
+/* Deposits and withdrawals are executed by a pool of worker threads. Each
+   account hashes to one of TX_STRIPES mutexes, so postings to different
+   accounts run in parallel while postings to one account are serialized.
+   Submissions are routed to a worker by the same hash, which keeps postings
+   to one account in submission order. The engine only posts balances; the
+   set of accounts must not change while it is running. */
+#define TX_STRIPES 1024
+#define TX_QUEUE_CAP 4096
+
+typedef struct {
+    int account;
+    char type;              /* 'D' deposit, 'W' withdrawal */
+    long amount;
+    const char *error;      /* NULL if applied */
+    long balance;           /* balance after the posting */
+} Transaction;
+
+typedef struct {
+    Transaction **ring;
+    int head, count;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty, not_full;
+    pthread_t thread;
+    struct TxEngine *engine;
+} TxWorker;
+
+typedef struct TxEngine {
+    TxWorker *workers;
+    int nworkers;
+    int deferred;           /* post with store_post_deferred */
+    int stopping;
+    long pending;
+    pthread_mutex_t done_lock;
+    pthread_cond_t all_done;
+} TxEngine;
+
+static pthread_mutex_t tx_stripes[TX_STRIPES];
+static pthread_once_t tx_stripes_once = PTHREAD_ONCE_INIT;
+
+static void tx_init_stripes(void) {
+    for (int i = 0; i < TX_STRIPES; ++i) pthread_mutex_init(&tx_stripes[i], NULL);
+}
+
+/* Validate and apply one posting under its account's stripe lock */
+int tx_execute(Transaction *t, int deferred) {
+    pthread_once(&tx_stripes_once, tx_init_stripes);
+    int i = store_find_customer(t->account);
+    if (i < 0) { t->error = "Account not found"; return -1; }
+    pthread_mutex_t *stripe = &tx_stripes[hash_int(t->account) % TX_STRIPES];
+    pthread_mutex_lock(stripe);
+    long balance = store.cust.hot[i].balance;
+    long delta = t->type == 'W' ? -t->amount : t->amount;
+    t->error = t->type == 'W' ? withdraw_error(balance, t->amount) : deposit_error(t->amount);
+    if (!t->error && (deferred ? store_post_deferred(i, delta) : store_post(i, delta)) != 0)
+        t->error = "Unable to record transaction";
+    t->balance = store.cust.hot[i].balance;
+    pthread_mutex_unlock(stripe);
+    return t->error ? -1 : 0;
+}
+
+static void *tx_worker_main(void *arg) {
+    TxWorker *w = arg;
+    TxEngine *e = w->engine;
+    for (;;) {
+        pthread_mutex_lock(&w->lock);
+        while (w->count == 0 && !e->stopping) pthread_cond_wait(&w->not_empty, &w->lock);
+        if (w->count == 0) { pthread_mutex_unlock(&w->lock); break; }
+        Transaction *t = w->ring[w->head];
+        w->head = (w->head + 1) % TX_QUEUE_CAP;
+        w->count--;
+        pthread_cond_signal(&w->not_full);
+        pthread_mutex_unlock(&w->lock);
+
+        tx_execute(t, e->deferred);
+
+        pthread_mutex_lock(&e->done_lock);
+        if (--e->pending == 0) pthread_cond_broadcast(&e->all_done);
+        pthread_mutex_unlock(&e->done_lock);
+    }
+    return NULL;
+}
+
+int tx_engine_start(TxEngine *e, int nworkers, int deferred) {
+    memset(e, 0, sizeof(*e));
+    if (nworkers < 1) nworkers = 1;
+    e->workers = calloc(nworkers, sizeof(TxWorker));
+    if (!e->workers) return -1;
+    e->deferred = deferred;
+    pthread_mutex_init(&e->done_lock, NULL);
+    pthread_cond_init(&e->all_done, NULL);
+    for (int k = 0; k < nworkers; ++k) {
+        TxWorker *w = &e->workers[k];
+        w->engine = e;
+        w->ring = malloc(TX_QUEUE_CAP * sizeof(Transaction *));
+        pthread_mutex_init(&w->lock, NULL);
+        pthread_cond_init(&w->not_empty, NULL);
+        pthread_cond_init(&w->not_full, NULL);
+        if (!w->ring || pthread_create(&w->thread, NULL, tx_worker_main, w) != 0) {
+            free(w->ring);
+            break;
+        }
+        e->nworkers++;
+    }
+    return e->nworkers == nworkers ? 0 : -1;
+}
+
+/* Queue a posting; t must stay valid until tx_engine_wait returns */
+void tx_submit(TxEngine *e, Transaction *t) {
+    TxWorker *w = &e->workers[hash_int(t->account) % (uint32_t)e->nworkers];
+    pthread_mutex_lock(&e->done_lock);
+    e->pending++;
+    pthread_mutex_unlock(&e->done_lock);
+    pthread_mutex_lock(&w->lock);
+    while (w->count == TX_QUEUE_CAP) pthread_cond_wait(&w->not_full, &w->lock);
+    w->ring[(w->head + w->count) % TX_QUEUE_CAP] = t;
+    w->count++;
+    pthread_cond_signal(&w->not_empty);
+    pthread_mutex_unlock(&w->lock);
+}
+
+/* Block until every submitted posting has been executed */
+void tx_engine_wait(TxEngine *e) {
+    pthread_mutex_lock(&e->done_lock);
+    while (e->pending > 0) pthread_cond_wait(&e->all_done, &e->done_lock);
+    pthread_mutex_unlock(&e->done_lock);
+}
+
+void tx_engine_stop(TxEngine *e) {
+    tx_engine_wait(e);
+    for (int k = 0; k < e->nworkers; ++k) {
+        TxWorker *w = &e->workers[k];
+        pthread_mutex_lock(&w->lock);
+        e->stopping = 1;
+        pthread_cond_signal(&w->not_empty);
+        pthread_mutex_unlock(&w->lock);
+    }
+    for (int k = 0; k < e->nworkers; ++k) {
+        TxWorker *w = &e->workers[k];
+        pthread_join(w->thread, NULL);
+        pthread_mutex_destroy(&w->lock);
+        pthread_cond_destroy(&w->not_empty);
+        pthread_cond_destroy(&w->not_full);
+        free(w->ring);
+    }
+    pthread_mutex_destroy(&e->done_lock);
+    pthread_cond_destroy(&e->all_done);
+    free(e->workers);
+    e->workers = NULL;
+    e->nworkers = 0;
+}
+
+/* ============================================================================
+   EXPORT ENGINE
+   ============================================================================ */
+
+/* Tables are exported as:
+     text   the original "LABEL : value" lines
+     csv    RFC 4180, with a header line
+     jsonl  one JSON object per line
+     fixed  columns padded to their largest possible width
+   with any subset of columns in any order. Rows are formatted a chunk of
+   EXPORT_CHUNK_ROWS at a time, with a hand-rolled integer formatter, into
+   buffers that go out in single write(2)s. Large tables are formatted by
+   several threads (BANKING_EXPORT_THREADS, default one per CPU) while the
+   calling thread writes finished chunks in order. Customer balances are
+   read from a SNAPSHOT, so postings carry on during the export. */
+#define EXPORT_CHUNK_ROWS 16384
+#define EXPORT_MAX_COLS 8
+
+typedef enum { EXPORT_TEXT, EXPORT_CSV, EXPORT_JSONL, EXPORT_FIXED } ExportFormat;
+
+static const char *const export_formats[] = { "text", "csv", "jsonl", "fixed" };
+
+typedef struct {
+    const char *name, *label;
+    int width;              /* longest value, for fixed */
+    int numeric;            /* right-aligned, unquoted in JSON */
+} ExportColumn;
+
+static const ExportColumn export_emp_columns[] = {
+    { "id", "EMPLOYEE ID", 10, 1 },
+    { "name", "EMPLOYEE NAME", MAX_NAME - 1, 0 },
+    { "salary", "EMPLOYEE SALARY", 31, 1 },
+    { "designation", "EMPLOYEE DESIGNATION", MAX_DESIGN - 1, 0 },
+};
+
+static const ExportColumn export_cust_columns[] = {
+    { "account", "ACCOUNT NUMBER", 10, 1 },
+    { "name", "CUSTOMER NAME", MAX_NAME - 1, 0 },
+    { "aadhaar", "AADHAAR NUMBER", MAX_AAD - 2, 0 },
+    { "phone", "PHONE NUMBER", MAX_PHONE - 2, 0 },
+    { "balance", "BANK ACCOUNT BALANCE", 20, 1 },
+    { "address", "ADDRESS", MAX_ADDR - 1, 0 },
+};
+
+typedef struct {
+    int employees;
+    ExportFormat format;
+    int cols[EXPORT_MAX_COLS], ncols;
+    size_t row_max;             /* bytes one row can take at most */
+} ExportSpec;
+
+/* Parse a format name and a comma separated column list into spec. An
+   empty list means all columns, or the original three for text. */
+int export_spec(ExportSpec *spec, int employees, const char *format, const char *columns) {
+    const ExportColumn *all = employees ? export_emp_columns : export_cust_columns;
+    int nall = employees ? 4 : 6;
+    memset(spec, 0, sizeof(*spec));
+    spec->employees = employees;
+    spec->format = EXPORT_TEXT;
+    while (spec->format <= EXPORT_FIXED && strcasecmp(format, export_formats[spec->format]) != 0) spec->format++;
+    if (spec->format > EXPORT_FIXED) return -1;
+    if (!columns || !columns[0]) {
+        static const int emp_text[] = { 0, 1, 3 }, cust_text[] = { 0, 1, 4 };
+        for (int k = 0; k < (spec->format == EXPORT_TEXT ? 3 : nall); ++k)
+            spec->cols[spec->ncols++] = spec->format != EXPORT_TEXT ? k : employees ? emp_text[k] : cust_text[k];
+    } else {
+        for (const char *p = columns; *p; ) {
+            size_t len = strcspn(p, ",");
+            int c = 0;
+            while (c < nall && (strlen(all[c].name) != len || strncasecmp(p, all[c].name, len) != 0)) c++;
+            if (c == nall || spec->ncols == EXPORT_MAX_COLS) return -1;
+            spec->cols[spec->ncols++] = c;
+            p += len;
+            if (*p == ',') p++;
+        }
+    }
+    /* A JSON escape can take 6 bytes per character, a CSV one 2 */
+    int expand = spec->format == EXPORT_JSONL ? 6 : spec->format == EXPORT_CSV ? 2 : 1;
+    spec->row_max = 4;
+    for (int k = 0; k < spec->ncols; ++k) {
+        const ExportColumn *col = &all[spec->cols[k]];
+        spec->row_max += strlen(col->name) + strlen(col->label) + expand * (size_t)col->width + 12;
+    }
+    return 0;
+}
+
+static const char export_digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Decimal form of v at p, two digits per step; returns its length */
+static int fmt_long(char *p, long v) {
+    char tmp[24], *t = tmp + sizeof(tmp);
+    unsigned long u = v < 0 ? 0UL - (unsigned long)v : (unsigned long)v;
+    while (u >= 100) {
+        t -= 2;
+        memcpy(t, export_digit_pairs + (u % 100) * 2, 2);
+        u /= 100;
+    }
+    if (u >= 10) {
+        t -= 2;
+        memcpy(t, export_digit_pairs + u * 2, 2);
+    } else {
+        *--t = (char)('0' + u);
+    }
+    int len = 0;
+    if (v < 0) p[len++] = '-';
+    memcpy(p + len, t, tmp + sizeof(tmp) - t);
+    return len + (int)(tmp + sizeof(tmp) - t);
+}
+
+/* Append one field; p has room for spec->row_max */
+static char *export_field(char *p, const ExportSpec *spec, const ExportColumn *col, int first,
+                          const char *s, size_t len) {
+    switch (spec->format) {
+        case EXPORT_TEXT: {
+            size_t n = strlen(col->label);
+            if (!first) { *p++ = ' '; *p++ = ' '; }
+            memcpy(p, col->label, n);
+            memcpy(p + n, " : ", 3);
+            memcpy(p + n + 3, s, len);
+            return p + n + 3 + len;
+        }
+        case EXPORT_CSV:
+            if (!first) *p++ = ',';
+            if (!memchr(s, ',', len) && !memchr(s, '"', len) && !memchr(s, '\n', len) && !memchr(s, '\r', len)) {
+                memcpy(p, s, len);
+                return p + len;
+            }
+            *p++ = '"';
+            for (size_t k = 0; k < len; ++k) {
+                if (s[k] == '"') *p++ = '"';
+                *p++ = s[k];
+            }
+            *p++ = '"';
+            return p;
+        case EXPORT_JSONL: {
+            *p++ = first ? '{' : ',';
+            *p++ = '"';
+            size_t n = strlen(col->name);
+            memcpy(p, col->name, n);
+            p += n;
+            *p++ = '"';
+            *p++ = ':';
+            int quote = !col->numeric || len == 0 || !isdigit((unsigned char)s[len - 1]);
+            if (quote) *p++ = '"';
+            for (size_t k = 0; k < len; ++k) {
+                unsigned char ch = (unsigned char)s[k];
+                if (ch == '"' || ch == '\\') { *p++ = '\\'; *p++ = (char)ch; }
+                else if (ch < 0x20) p += sprintf(p, "\\u%04x", ch);
+                else *p++ = (char)ch;
+            }
+            if (quote) *p++ = '"';
+            return p;
+        }
+        case EXPORT_FIXED: {
+            if (!first) *p++ = ' ';
+            int pad = col->width > (int)len ? col->width - (int)len : 0;
+            if (col->numeric) { memset(p, ' ', pad); p += pad; }
+            memcpy(p, s, len);
+            p += len;
+            if (!col->numeric) { memset(p, ' ', pad); p += pad; }
+            return p;
+        }
+    }
+    return p;
+}
+
+/* One chunk's output, owned by a formatting thread until ready, then by
+   the writer until written */
+typedef struct {
+    char *data;
+    size_t len, cap;
+    long *balance;
+    int chunk;              /* -1 = free */
+    int ready;
+} ExportSlot;
+
+/* Format rows first..first+n-1 into slot; slot->balance holds the
+   customers' balances. The buffer keeps its size between chunks. */
+static int export_rows(const ExportSpec *spec, int first, int n, ExportSlot *slot) {
+    const ExportColumn *all = spec->employees ? export_emp_columns : export_cust_columns;
+    static const CustField cust_field[] = { 0, CF_NAME, CF_AADHAAR, CF_PHONE, 0, CF_ADDRESS };
+    char num[24];
+    slot->len = 0;
+    for (int r = 0; r < n; ++r) {
+        if (slot->cap - slot->len < spec->row_max) {
+            size_t cap = slot->cap ? slot->cap * 2 : (size_t)EXPORT_CHUNK_ROWS * 128;
+            while (cap - slot->len < spec->row_max) cap *= 2;
+            char *grown = realloc(slot->data, cap);
+            if (!grown) return -1;
+            slot->data = grown;
+            slot->cap = cap;
+        }
+        char *p = slot->data + slot->len;
+        int i = first + r;
+        for (int k = 0; k < spec->ncols; ++k) {
+            int c = spec->cols[k];
+            const char *s = num;
+            size_t len;
+            if (spec->employees) {
+                const Employee *e = &store.emps[i];
+                if (c == 0) len = fmt_long(num, e->id);
+                else len = strlen(s = c == 1 ? e->name : c == 2 ? e->salary : e->designation);
+            } else if (c == 0 || c == 4) {
+                len = fmt_long(num, c == 0 ? store.cust.hot[i].account : slot->balance[r]);
+            } else {
+                len = strlen(s = ct_str(&store.cust, i, cust_field[c]));
+            }
+            p = export_field(p, spec, &all[c], k == 0, s, len);
+        }
+        if (spec->format == EXPORT_JSONL) *p++ = '}';
+        *p++ = '\n';
+        slot->len = p - slot->data;
+    }
+    return 0;
+}
+
+typedef struct {
+    const ExportSpec *spec;
+    const Snapshot *snap;
+    int rows, nchunks;
+    ExportSlot *slots;
+    int nslots;
+    int next_chunk;
+    int failed;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} ExportJob;
+
+static int export_chunk(ExportJob *job, ExportSlot *slot, int k) {
+    int first = k * EXPORT_CHUNK_ROWS;
+    int n = job->rows - first < EXPORT_CHUNK_ROWS ? job->rows - first : EXPORT_CHUNK_ROWS;
+    if (job->snap) store_snapshot_balances(job->snap, first, n, slot->balance);
+    return export_rows(job->spec, first, n, slot);
+}
+
+static void *export_worker(void *arg) {
+    ExportJob *job = arg;
+    pthread_mutex_lock(&job->lock);
+    while (!job->failed && job->next_chunk < job->nchunks) {
+        int k = job->next_chunk++;
+        ExportSlot *slot = &job->slots[k % job->nslots];
+        while (slot->chunk != -1 && !job->failed) pthread_cond_wait(&job->changed, &job->lock);
+        if (job->failed) break;
+        slot->chunk = k;
+        slot->ready = 0;
+        pthread_mutex_unlock(&job->lock);
+        int rc = export_chunk(job, slot, k);
+        pthread_mutex_lock(&job->lock);
+        slot->ready = 1;
+        if (rc != 0) job->failed = 1;
+        pthread_cond_broadcast(&job->changed);
+    }
+    pthread_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+static int export_write(int fd, const char *p, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* Export a table to path as spec says. Returns the rows written, -1 on error. */
+long export_table(const ExportSpec *spec, const char *path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    const ExportColumn *all = spec->employees ? export_emp_columns : export_cust_columns;
+    Snapshot snap;
+    ExportJob job = { .spec = spec, .snap = spec->employees ? NULL : &snap };
+    if (!spec->employees) store_snapshot_begin(&snap);
+    job.rows = spec->employees ? store.emp_count : snap.count;
+    job.nchunks = (job.rows + EXPORT_CHUNK_ROWS - 1) / EXPORT_CHUNK_ROWS;
+    int threads = (int)env_long("BANKING_EXPORT_THREADS", online_cpus());
+    if (threads > job.nchunks - 1) threads = job.nchunks - 1;   /* the writer formats when alone */
+    if (threads < 0) threads = 0;
+    job.nslots = threads ? 2 * threads : 1;
+    job.slots = calloc(job.nslots, sizeof(ExportSlot));
+    int rc = job.slots ? 0 : -1;
+    for (int s = 0; rc == 0 && s < job.nslots; ++s) {
+        job.slots[s].chunk = -1;
+        job.slots[s].balance = malloc(EXPORT_CHUNK_ROWS * sizeof(long));
+        if (!job.slots[s].balance) rc = -1;
+    }
+    if (rc == 0 && spec->format == EXPORT_CSV) {
+        char header[EXPORT_MAX_COLS * 16], *p = header;
+        for (int k = 0; k < spec->ncols; ++k) {
+            const char *name = all[spec->cols[k]].name;
+            p = export_field(p, spec, &all[spec->cols[k]], k == 0, name, strlen(name));
+        }
+        *p++ = '\n';
+        rc = export_write(fd, header, p - header);
+    }
+    pthread_t *tids = threads ? malloc(threads * sizeof(pthread_t)) : NULL;
+    int started = 0;
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.changed, NULL);
+    if (rc == 0 && tids) {
+        while (started < threads && pthread_create(&tids[started], NULL, export_worker, &job) == 0) started++;
+    }
+    for (int k = 0; rc == 0 && k < job.nchunks; ++k) {
+        ExportSlot *slot = &job.slots[k % job.nslots];
+        if (started == 0) {
+            rc = export_chunk(&job, slot, k);
+        } else {
+            pthread_mutex_lock(&job.lock);
+            while (!(slot->chunk == k && slot->ready) && !job.failed) pthread_cond_wait(&job.changed, &job.lock);
+            if (job.failed) rc = -1;
+            pthread_mutex_unlock(&job.lock);
+        }
+        if (rc == 0) rc = export_write(fd, slot->data, slot->len);
+        pthread_mutex_lock(&job.lock);
+        slot->chunk = -1;
+        if (rc != 0) job.failed = 1;
+        pthread_cond_broadcast(&job.changed);
+        pthread_mutex_unlock(&job.lock);
+    }
+    for (int t = 0; t < started; ++t) pthread_join(tids[t], NULL);
+    pthread_mutex_destroy(&job.lock);
+    pthread_cond_destroy(&job.changed);
+    free(tids);
+    for (int s = 0; job.slots && s < job.nslots; ++s) {
+        free(job.slots[s].data);
+        free(job.slots[s].balance);
+    }
+    free(job.slots);
+    if (!spec->employees && store_snapshot_end(&snap) != 0) rc = -1;
+    if (close(fd) != 0) rc = -1;
+    return rc == 0 ? job.rows : -1;
+}
+
+/* ============================================================================
+   BULK IMPORT
+   ============================================================================ */
+
+/* CSV rows (RFC 4180 quoting, so a quoted field may span lines) are
+   checked against the rules create_new applies at its prompts, with the
+   character classes tested eight bytes at a time (SWAR). The data files
+   hold one record per line, so a field with a line break is rejected; the
+   rejects file shows such breaks as \n. A first line made of column names
+   picks the column order; without one the order is that of
+   IMPORT_CUST_COLUMNS / IMPORT_EMP_COLUMNS.
+   Accepted rows are staged into the store, whose indexes catch aadhaar and
+   phone numbers repeated within the file as well as against existing
+   customers, and are committed with one write at the end. */
+#define IMPORT_MAX_FIELDS 8
+#define IMPORT_CUST_COLUMNS "name,aadhaar,phone,deposit,address"
+#define IMPORT_EMP_COLUMNS "name,salary,designation"
+
+#define SWAR_ONES 0x0101010101010101ULL
+#define SWAR_HIGH 0x8080808080808080ULL
+
+/* Up to 8 bytes of s, padded with pad */
+static uint64_t swar_load(const char *s, size_t len, unsigned char pad) {
+    uint64_t w = SWAR_ONES * pad;
+    memcpy(&w, s, len < 8 ? len : 8);
+    return w;
+}
+
+/* High bit of each lane set where the byte is zero, exact per lane */
+static uint64_t swar_zero_lanes(uint64_t w) {
+    return ~(((w & ~SWAR_HIGH) + ~SWAR_HIGH) | w) & SWAR_HIGH;
+}
+
+/* Every byte of s is '0'..'9' (is_numeric) */
+static int swar_is_numeric(const char *s, size_t len) {
+    if (len == 0) return 0;
+    for (size_t k = 0; k < len; k += 8) {
+        uint64_t w = swar_load(s + k, len - k, '0');
+        /* high nibble 3, and low nibble + 6 does not carry out of it */
+        if ((w & (SWAR_ONES * 0xF0)) != SWAR_ONES * 0x30 || (((w & (SWAR_ONES * 0x0F)) + SWAR_ONES * 6) & (SWAR_ONES * 0xF0)))
+            return 0;
+    }
+    return 1;
+}
+
+/* Every byte of s is an ASCII letter or a space (is_alphabetic) */
+static int swar_is_alphabetic(const char *s, size_t len) {
+    if (len == 0) return 0;
+    for (size_t k = 0; k < len; k += 8) {
+        uint64_t w = swar_load(s + k, len - k, 'a');
+        if ((w & SWAR_HIGH) || swar_zero_lanes(w)) return 0;
+        uint64_t y = w | SWAR_ONES * 0x20;             /* fold case; space stays */
+        uint64_t letter = (y + SWAR_ONES * (0x80 - 'a')) & ~(y + SWAR_ONES * (0x80 - 'z' - 1));
+        uint64_t space = swar_zero_lanes(y ^ SWAR_ONES * ' ');
+        if (((letter | space) & SWAR_HIGH) != SWAR_HIGH) return 0;
+    }
+    return 1;
+}
+
+/* Split a line into at most max fields in place, undoing CSV quoting.
+   Returns the field count, -1 if a quote is unbalanced or there are too
+   many fields. */
+static int csv_split(char *line, char **field, size_t *len, int max) {
+    int n = 0;
+    char *p = line;
+    for (;;) {
+        if (n == max) return -1;
+        field[n] = p;
+        if (*p == '"') {
+            char *out = p, *in = p + 1;
+            for (;;) {
+                if (*in == '\0') return -1;
+                if (*in == '"' && in[1] != '"') break;
+                if (*in == '"') in++;
+                *out++ = *in++;
+            }
+            len[n++] = out - p;
+            *out = '\0';           /* the quotes removed leave room */
+            p = in + 1;
+            if (*p != ',' && *p != '\0') return -1;
+        } else {
+            char *end = p + strcspn(p, ",");
+            len[n++] = end - p;
+            p = end;
+        }
+        if (*p == '\0') return n;
+        *p++ = '\0';
+    }
+}
+
+/* Whether a quoted field is still open at the end of s, given whether one
+   was open at its start */
+static int csv_open_quote(const char *s, size_t len, int quote) {
+    int start = !quote;     /* the next byte begins a field */
+    for (size_t k = 0; k < len; ++k) {
+        if (quote) {
+            if (s[k] == '"') {
+                if (k + 1 < len && s[k+1] == '"') k++;
+                else quote = 0;
+            }
+        } else if (s[k] == '"' && start) {
+            quote = 1;
+        }
+        start = !quote && s[k] == ',';
+    }
+    return quote;
+}
+
+/* Read one CSV record into *rec without its line ending, joining lines
+   while a quoted field is open (the field keeps a \n for each break).
+   *lines counts the lines read. Returns the record length, -1 at the end
+   of in, -2 out of memory. */
+static ssize_t csv_read_record(char **rec, size_t *cap, FILE *in, long *lines) {
+    errno = 0;
+    ssize_t n = getline(rec, cap, in);
+    if (n < 0) return errno == ENOMEM ? -2 : -1;
+    (*lines)++;
+    size_t from = 0;
+    int quote = 0;
+    for (;;) {
+        while ((size_t)n > from && ((*rec)[n-1] == '\n' || (*rec)[n-1] == '\r')) (*rec)[--n] = '\0';
+        if (!(quote = csv_open_quote(*rec + from, n - from, quote))) return n;
+        char *more = NULL;
+        size_t more_cap = 0;
+        errno = 0;
+        ssize_t m = getline(&more, &more_cap, in);
+        if (m < 0) {        /* unterminated; csv_split rejects it */
+            free(more);
+            return errno == ENOMEM ? -2 : n;
+        }
+        (*lines)++;
+        if ((size_t)(n + m + 2) > *cap) {
+            char *grown = realloc(*rec, n + m + 2);
+            if (!grown) { free(more); return -2; }
+            *rec = grown;
+            *cap = n + m + 2;
+        }
+        (*rec)[n++] = '\n';
+        memcpy(*rec + n, more, m + 1);
+        from = n;
+        n += m;
+        free(more);
+    }
+}
+
+/* LINE|ROW|REJECTED|REASON, with line breaks in the row shown as \n */
+static void import_reject(FILE *rej, long lineno, const char *row, const char *err) {
+    fprintf(rej, "%ld|", lineno);
+    for (size_t k; row[k = strcspn(row, "\n")]; row += k + 1) fprintf(rej, "%.*s\\n", (int)k, row);
+    fprintf(rej, "%s|REJECTED|%s\n", row, err);
+}
+
+/* Column positions of an import: map[k] is the field holding column k of
+   the table's IMPORT_*_COLUMNS, or -1 */
+typedef struct {
+    int employees;
+    int map[IMPORT_MAX_FIELDS];
+    int nfields;            /* fields a row must have */
+} ImportLayout;
+
+static int import_column(int employees, const char *name, size_t len) {
+    static const char *const cust[] = { "name", "aadhaar", "phone", "deposit", "address" };
+    static const char *const emp[] = { "name", "salary", "designation" };
+    const char *const *cols = employees ? emp : cust;
+    int n = employees ? 3 : 5;
+    for (int k = 0; k < n; ++k)
+        if (strlen(cols[k]) == len && strncasecmp(name, cols[k], len) == 0) return k;
+    /* columns an export carries that an import assigns itself */
+    if (len == 7 && !employees && strncasecmp(name, "balance", 7) == 0) return 3;
+    if ((len == 7 && !employees && strncasecmp(name, "account", 7) == 0) ||
+        (len == 2 && employees && strncasecmp(name, "id", 2) == 0)) return IMPORT_MAX_FIELDS;
+    return -1;
+}
+
+/* Take the fields of a header line as the layout if they are all column
+   names covering every column. Returns 1 if it was a header. */
+static int import_header(ImportLayout *l, char **field, size_t *len, int n) {
+    int need = l->employees ? 3 : 5, seen = 0, map[IMPORT_MAX_FIELDS];
+    for (int k = 0; k < IMPORT_MAX_FIELDS; ++k) map[k] = -1;
+    for (int f = 0; f < n; ++f) {
+        int c = import_column(l->employees, field[f], len[f]);
+        if (c < 0) return 0;
+        if (c < IMPORT_MAX_FIELDS && map[c] < 0) { map[c] = f; seen++; }
+    }
+    if (seen != need) return 0;
+    memcpy(l->map, map, sizeof(map));
+    l->nfields = n;
+    return 1;
+}
+
+/* Copy a field into a record's buffer; NULL if it does not fit or holds
+   the store's delimiter */
+static const char *import_text(char *dst, size_t size, const char *src, size_t len, const char *what) {
+    if (len >= size) return what;
+    if (memchr(src, '|', len)) return "Field contains '|'";
+    if (memchr(src, '\n', len) || memchr(src, '\r', len)) return "Field contains a line break";
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+    return NULL;
+}
+
+/* Validate a customer row into c; NULL if accepted */
+static const char *import_customer(const ImportLayout *l, char **field, size_t *len, Customer *c) {
+    const char *name = field[l->map[0]], *aadhaar = field[l->map[1]], *phone = field[l->map[2]];
+    const char *deposit = field[l->map[3]], *address = field[l->map[4]];
+    size_t nlen = len[l->map[0]], alen = len[l->map[1]], plen = len[l->map[2]];
+    size_t dlen = len[l->map[3]], adlen = len[l->map[4]];
+    const char *err;
+    if (!swar_is_alphabetic(name, nlen)) return "Invalid name - must contain only letters and spaces";
+    if ((err = import_text(c->name, sizeof(c->name), name, nlen, "Name too long")) != NULL) return err;
+    if (alen != 12 || !swar_is_numeric(aadhaar, alen)) return "Invalid aadhaar - must be exactly 12 digits";
+    memcpy(c->aadhaar, aadhaar, alen + 1);
+    if (store_find_aadhaar(c->aadhaar) >= 0) return "Aadhaar already registered to another account";
+    if (plen != 10 || !swar_is_numeric(phone, plen)) return "Invalid phone - must be exactly 10 digits";
+    memcpy(c->phone, phone, plen + 1);
+    if (store_find_phone(c->phone) >= 0) return "Phone already registered to another account";
+    if (!swar_is_numeric(deposit, dlen)) return "Invalid amount - must contain only digits";
+    c->balance = dlen > 6 ? MAX_DEPOSIT + 1 : atol(deposit);
+    if (c->balance < MIN_DEPOSIT) return "Deposit must be at least 1000";
+    if (c->balance > MAX_DEPOSIT) return "Deposit cannot exceed 50000";
+    if (adlen == 0) return "Address cannot be empty";
+    return import_text(c->address, sizeof(c->address), address, adlen, "Address too long");
+}
+
+static const char *import_employee(const ImportLayout *l, char **field, size_t *len, Employee *e) {
+    const char *name = field[l->map[0]], *salary = field[l->map[1]], *designation = field[l->map[2]];
+    size_t nlen = len[l->map[0]], slen = len[l->map[1]], dlen = len[l->map[2]];
+    const char *err;
+    if (!swar_is_alphabetic(name, nlen)) return "Invalid name - must contain only letters and spaces";
+    if ((err = import_text(e->name, sizeof(e->name), name, nlen, "Name too long")) != NULL) return err;
+    if (!swar_is_numeric(salary, slen)) return "Invalid salary - must contain only digits";
+    if ((err = import_text(e->salary, sizeof(e->salary), salary, slen, "Salary too long")) != NULL) return err;
+    if (!swar_is_alphabetic(designation, dlen)) return "Invalid designation - must contain only letters and spaces";
+    return import_text(e->designation, sizeof(e->designation), designation, dlen, "Designation too long");
+}
+
+/* Import the rows of in, writing every rejected row to rej as
+   LINE|ROW|REJECTED|REASON (LINE being the row's first line). Returns -1,
+   with nothing committed, if memory ran out or the commit failed. */
+int import_csv(int employees, FILE *in, FILE *rej, long *imported, long *rejected) {
+    ImportLayout l = { .employees = employees, .nfields = employees ? 3 : 5 };
+    for (int k = 0; k < IMPORT_MAX_FIELDS; ++k) l.map[k] = k < l.nfields ? k : -1;
+    int first_emp = store.emp_count, first_cust = store.cust.count;
+    char *line = NULL, *copy = NULL, *field[IMPORT_MAX_FIELDS];
+    size_t cap = 0, copy_cap = 0, len[IMPORT_MAX_FIELDS];
+    ssize_t n;
+    long lines = 0, lineno;
+    int oom = 0;
+    *imported = *rejected = 0;
+    while (lineno = lines + 1, (n = csv_read_record(&line, &cap, in, &lines)) >= 0) {
+        if (n == 0) continue;
+        if ((size_t)n + 1 > copy_cap) {
+            char *grown = realloc(copy, n + 1);
+            if (!grown) { oom = 1; break; }
+            copy = grown;
+            copy_cap = n + 1;
+        }
+        memcpy(copy, line, n + 1);
+        int nf = csv_split(line, field, len, IMPORT_MAX_FIELDS);
+        if (lineno == 1 && nf > 0 && import_header(&l, field, len, nf)) continue;
+        const char *err = NULL;
+        if (nf != l.nfields) {
+            err = nf < 0 ? "Malformed CSV" : "Wrong number of fields";
+        } else if (employees) {
+            Employee e;
+            err = import_employee(&l, field, len, &e);
+            if (!err && store_stage_employee(&e) != 0) err = "Unable to save employee";
+        } else {
+            Customer c;
+            err = import_customer(&l, field, len, &c);
+            if (!err && store_stage_customer(&c) != 0) err = "Unable to save customer";
+        }
+        if (err) {
+            import_reject(rej, lineno, copy, err);
+            (*rejected)++;
+        } else {
+            (*imported)++;
+        }
+    }
+    free(line);
+    free(copy);
+    if (oom || n == -2) {
+        fprintf(stderr, "Out of memory at line %ld\n", lineno);
+        return -1;          /* the staged rows are dropped with the store */
+    }
+    return store_commit_staged(first_emp, first_cust);
+}
+
+/* ============================================================================
+   PRINT FUNCTIONS
+   ============================================================================ */
+
+static void print_employee_header(int count) {
+    printf("\n--- Employees (%d) ---\n", count);
+    printf("%-6s | %-20s | %-10s | %-12s\n", "ID", "Name", "Salary", "Designation");
+    printf("---------------------------------------------------------------\n");
+}
+
+static void print_employee_row(const Employee *e) {
+    printf("%-6d | %-20s | %-10s | %-12s\n", e->id, e->name, e->salary, e->designation);
+}
+
+static void print_employees(const Employee *emps, int count) {
+    if (count == 0) {
+        printf("\n\tData file was empty\n");
+        return;
+    }
+    print_employee_header(count);
+    for (int i = 0; i < count; ++i) print_employee_row(&emps[i]);
+}
+
+static void print_customer_header(int count) {
+    printf("\n--- Customers (%d) ---\n", count);
+    printf("%-6s | %-20s | %-12s | %-10s | %-10s | %-20s\n", "Acc", "Name", "aadhaar", "Phone", "Balance", "Address");
+    printf("-----------------------------------------------------------------------------------------------\n");
+}
+
+/* balance is passed in so a snapshot's balance can be shown */
+static void print_customer_row(const CustTable *t, int i, long balance) {
+    printf("%-6d | %-20s | %-12s | %-10s | %-10ld | %-20s\n", t->hot[i].account, ct_str(t, i, CF_NAME),
+           ct_str(t, i, CF_AADHAAR), ct_str(t, i, CF_PHONE), balance, ct_str(t, i, CF_ADDRESS));
+}
+
+static void print_customer(const CustTable *t, int i) {
+    print_customer_header(1);
+    print_customer_row(t, i, t->hot[i].balance);
+}
+
+/* The records at the given positions, in that order */
+static void print_customer_set(const CustTable *t, const int *pos, int count) {
+    print_customer_header(count);
+    for (int n = 0; n < count; ++n) print_customer_row(t, pos[n], t->hot[pos[n]].balance);
+}
+
+/* ============================================================================
+   MENU OPERATIONS
+   ============================================================================ */
+
+void create_new() {
+    printf("\n\t1. Employee\n\t2. Customer\n");
+    char buf[32];
+    read_line_input("\n\tEnter your choice: ", buf, sizeof(buf));
+    int ch = atoi(buf);
     if (ch == 1) {
-        Employee *emps = NULL; int count = 0;
-        load_employees(&emps, &count);
-        int id = count ? (emps[count-1].id + 1) : 1;
-        free(emps);
         Employee e;
-        e.id = id;
+        e.id = store_next_employee_id();
         
         /* Validate employee name - must be alphabetic */
         while (1) {
@@ -271,754 +5382,2685 @@ void create_new() {
                 printf("\n\tName cannot be empty\n");
                 continue;
             }
-            if (!is_alphabetic(e.name)) {
-                printf("\n\tInvalid name - must contain only letters and spaces\n");
-                continue;
+            if (!is_alphabetic(e.name)) {
+                printf("\n\tInvalid name - must contain only letters and spaces\n");
+                continue;
+            }
+            break;
+        }
+        
+        /* Validate salary - must be numeric */
+        while (1) {
+            read_line_input("\n\tEnter employee salary: ", e.salary, sizeof(e.salary));
+            if (strlen(e.salary) == 0) {
+                printf("\n\tSalary cannot be empty\n");
+                continue;
+            }
+            if (!is_numeric(e.salary)) {
+                printf("\n\tInvalid salary - must contain only digits\n");
+                continue;
+            }
+            break;
+        }
+        
+        /* Validate designation - must be alphabetic */
+        while (1) {
+            read_line_input("\n\tEnter employee designation: ", e.designation, sizeof(e.designation));
+            if (strlen(e.designation) == 0) {
+                printf("\n\tDesignation cannot be empty\n");
+                continue;
+            }
+            if (!is_alphabetic(e.designation)) {
+                printf("\n\tInvalid designation - must contain only letters and spaces\n");
+                continue;
+            }
+            break;
+        }
+        
+        if (store_add_employee(&e) != 0) {
+            printf("\n\tUnable to save employee\n");
+            return;
+        }
+        printf("\n\tEmployee saved. ID: %d\n", e.id);
+    } else if (ch == 2) {
+        Customer c;
+        c.account = store_next_account();
+        char balbuf[64];
+        while (1) {
+            /* Validate customer name - must be alphabetic */
+            read_line_input("\n\tEnter customer name: ", c.name, sizeof(c.name));
+            if (strlen(c.name) == 0) { 
+                printf("\n\tName cannot be empty\n"); 
+                continue; 
+            }
+            if (!is_alphabetic(c.name)) {
+                printf("\n\tInvalid name - must contain only letters and spaces\n");
+                continue;
+            }
+            
+            /* Validate aadhaar - exactly 12 digits */
+            read_line_input("\n\tEnter aadhaar (12 digits): ", c.aadhaar, sizeof(c.aadhaar));
+            if (strlen(c.aadhaar) != 12 || !is_numeric(c.aadhaar)) { 
+                printf("\n\tInvalid aadhaar - must be exactly 12 digits\n"); 
+                continue;
+            }
+            if (store_find_aadhaar(c.aadhaar) >= 0) {
+                printf("\n\tAadhaar already registered to another account\n");
+                continue;
+            }
+            
+            /* Validate phone - exactly 10 digits */
+            read_line_input("\n\tEnter phone (10 digits): ", c.phone, sizeof(c.phone));
+            if (strlen(c.phone) != 10 || !is_numeric(c.phone)) { 
+                printf("\n\tInvalid phone - must be exactly 10 digits\n"); 
+                continue;
+            }
+            if (store_find_phone(c.phone) >= 0) {
+                printf("\n\tPhone already registered to another account\n");
+                continue;
+            }
+            
+            /* Validate initial deposit - must be numeric and >= 1000 */
+            read_line_input("\n\tEnter initial deposit (min 1000 & max 50000): ", balbuf, sizeof(balbuf));
+            if (!is_numeric(balbuf)) {
+                printf("\n\tInvalid amount - must contain only digits\n");
+                continue;
+            }
+            long bal = atol(balbuf);
+            if (bal < 1000) { 
+                printf("\n\tDeposit must be at least 1000\n"); 
+                continue;
+            }
+            if (bal > 50000) { 
+                printf("\n\tDeposit cannot exceed 50000\n"); 
+                continue;
+            }
+            c.balance = bal;
+            
+            /* Validate address - cannot be empty */
+            read_line_input("\n\tEnter address: ", c.address, sizeof(c.address));
+            if (strlen(c.address) == 0) { 
+                printf("\n\tAddress cannot be empty\n"); 
+                continue; 
+            }
+            
+            if (store_add_customer(&c) != 0) {
+                printf("\n\tUnable to save customer\n");
+                return;
+            }
+            printf("\n\tCustomer saved. Account: %d  Balance: %ld\n", c.account, c.balance);
+            break;
+        }
+    } else {
+        printf("\n\tInvalid choice\n");
+    }
+}
+
+/* view_all pages through a table with a cursor over its positions in the
+   chosen order; only the rows of the page on screen are formatted. Balance
+   order is read off the BALANCE INDEX, account and ID order is normally the
+   file order already, and anything else goes through the PARALLEL SORT. */
+#define VIEW_PAGE_SIZE 20
+
+/* Ties fall back to file order, so every listing is deterministic */
+static int view_cmp_emp_id(int a, int b) {
+    int x = store.emps[a].id, y = store.emps[b].id;
+    return x != y ? (x > y) - (x < y) : a - b;
+}
+
+static int view_cmp_emp_name(int a, int b) {
+    int c = strcasecmp(store.emps[a].name, store.emps[b].name);
+    return c ? c : a - b;
+}
+
+static int view_cmp_emp_designation(int a, int b) {
+    int c = strcasecmp(store.emps[a].designation, store.emps[b].designation);
+    return c ? c : a - b;
+}
+
+static int view_cmp_cust_account(int a, int b) {
+    int x = store.cust.hot[a].account, y = store.cust.hot[b].account;
+    return x != y ? (x > y) - (x < y) : a - b;
+}
+
+static int view_cmp_cust_name(int a, int b) {
+    int c = strcasecmp(ct_str(&store.cust, a, CF_NAME), ct_str(&store.cust, b, CF_NAME));
+    return c ? c : a - b;
+}
+
+/* Positions in ascending key order into *order, left NULL when the file
+   order already is that order. *descending is set if the array came out
+   highest first (salary or balance index). Returns -1 on failure. */
+static int view_order(int employees, PosCompare cmp, int by_amount, int **order, int *descending) {
+    int count = employees ? store.emp_count : store.cust.count;
+    *order = NULL;
+    *descending = 0;
+    if (by_amount) {
+        *descending = 1;
+        int n = employees ? store_find_salaries(LONG_MIN, LONG_MAX, order)
+                          : store_find_balances(LONG_MIN, LONG_MAX, INT_MAX, order);
+        return n == count ? 0 : -1;
+    }
+    int sorted = 1;
+    for (int i = 1; sorted && i < count; ++i) sorted = cmp(i - 1, i) < 0;
+    if (sorted) return 0;
+    int *pos = malloc((count ? count : 1) * sizeof(int));
+    if (!pos) return -1;
+    for (int i = 0; i < count; ++i) pos[i] = i;
+    if (sort_positions(pos, count, cmp) != 0) { free(pos); return -1; }
+    *order = pos;
+    return 0;
+}
+
+/* Show VIEW_PAGE_SIZE rows at a time; row r is order[r] (or position r
+   without an order), walked from the end when reverse is set. Customer
+   balances come from snap when given. */
+static void view_pages(int employees, const int *order, int count, int reverse, const Snapshot *snap) {
+    int pages = (count + VIEW_PAGE_SIZE - 1) / VIEW_PAGE_SIZE, page = 0;
+    char buf[32];
+    for (;;) {
+        int first = page * VIEW_PAGE_SIZE;
+        int n = count - first < VIEW_PAGE_SIZE ? count - first : VIEW_PAGE_SIZE;
+        if (employees) print_employee_header(count);
+        else print_customer_header(count);
+        for (int r = first; r < first + n; ++r) {
+            int k = reverse ? count - 1 - r : r;
+            int i = order ? order[k] : k;
+            long balance = employees ? 0 : store.cust.hot[i].balance;
+            if (snap && !employees) store_snapshot_balances(snap, i, 1, &balance);
+            if (employees) print_employee_row(&store.emps[i]);
+            else print_customer_row(&store.cust, i, balance);
+        }
+        if (pages == 1) return;
+        printf("\n\tPage %d of %d (rows %d-%d)\n", page + 1, pages, first + 1, first + n);
+        read_line_input("\n\tn = next, p = previous, page number, q = quit: ", buf, sizeof(buf));
+        if (buf[0] == 'n' || buf[0] == 'N') {
+            if (page + 1 < pages) page++;
+        } else if (buf[0] == 'p' || buf[0] == 'P') {
+            if (page > 0) page--;
+        } else if (is_numeric(buf) && atoi(buf) >= 1 && atoi(buf) <= pages) {
+            page = atoi(buf) - 1;
+        } else {
+            return;
+        }
+    }
+}
+
+void view_all() {
+    printf("\n\t1. View Employees\n\t2. View Customers\n");
+    char buf[32];
+    read_line_input("\n\tEnter choice: ", buf, sizeof(buf));
+    int ch = atoi(buf);
+    if (ch != 1 && ch != 2) {
+        printf("\n\tInvalid choice\n");
+        return;
+    }
+    int employees = ch == 1;
+    int count = employees ? store.emp_count : store.cust.count;
+    if (count == 0) {
+        printf("\n\tData file was empty\n");
+        return;
+    }
+    PosCompare cmp = NULL;
+    int by_amount = 0;
+    if (employees) {
+        read_line_input("\n\tSort by:\n\t1. ID\n\t2. Name\n\t3. Salary\n\t4. Designation\n\tEnter: ", buf, sizeof(buf));
+        switch (atoi(buf)) {
+            case 2:  cmp = view_cmp_emp_name; break;
+            case 3:  by_amount = 1; break;
+            case 4:  cmp = view_cmp_emp_designation; break;
+            default: cmp = view_cmp_emp_id; break;
+        }
+    } else {
+        read_line_input("\n\tSort by:\n\t1. Account\n\t2. Name\n\t3. Balance\n\tEnter: ", buf, sizeof(buf));
+        switch (atoi(buf)) {
+            case 2:  cmp = view_cmp_cust_name; break;
+            case 3:  by_amount = 1; break;
+            default: cmp = view_cmp_cust_account; break;
+        }
+    }
+    read_line_input("\n\t1. Ascending\n\t2. Descending\n\tEnter: ", buf, sizeof(buf));
+    int descending = atoi(buf) == 2;
+
+    /* Customers are listed as of one moment, however long the paging takes */
+    Snapshot snap;
+    if (!employees) store_snapshot_begin(&snap);
+    int *order, order_desc;
+    if (view_order(employees, cmp, by_amount, &order, &order_desc) != 0) {
+        printf("\n\tOut of memory\n");
+    } else {
+        view_pages(employees, order, count, descending != order_desc, employees ? NULL : &snap);
+    }
+    if (!employees && store_snapshot_end(&snap) != 0) printf("\n\tOut of memory: balances shown may have moved\n");
+    free(order);
+}
+
+/* Prefix or fuzzy name search through the NAME INDEX, shown a page at a time */
+static void search_names(int employees, int prefix) {
+    char buf[MAX_NAME];
+    read_line_input(prefix ? "\n\tName starts with: " : "\n\tName: ", buf, sizeof(buf));
+    if (strlen(buf) == 0) { printf("\n\tInvalid name\n"); return; }
+    int *pos;
+    int n = prefix ? store_find_name_prefix(employees, buf, &pos)
+                   : store_find_name_similar(employees, buf, &pos);
+    if (n > 0) view_pages(employees, pos, n, 0, NULL);
+    else if (n == 0) printf(employees ? "\n\tNo employee found.\n" : "\n\tNo customer found.\n");
+    else printf("\n\tOut of memory\n");
+    free(pos);
+}
+
+void search_data() {
+    printf("\n\t1. Search Employee\n\t2. Search Customer\n");
+    char buf[64];
+    read_line_input("\n\tEnter choice: ", buf, sizeof(buf));
+    int ch = atoi(buf);
+    if (ch == 1) {
+        Employee *emps = store.emps; int count = store.emp_count;
+        if (count == 0) {
+            printf("\n\tData file was empty\n");
+            return;
+        }
+        printf("\n\t1. By Designation\n\t2. By Name\n\t3. By ID\n\t4. Name Starts With\n\t5. Similar Name\n"
+               "\t6. Salary Range\n");
+        read_line_input("\n\tEnter: ", buf, sizeof(buf));
+        int opt = atoi(buf);
+        
+        
+        if (opt == 1 || opt == 6) {
+            int *pos, n;
+            if (opt == 1) {
+                read_line_input("\n\tEnter designation: ", buf, sizeof(buf));
+                n = store_find_designation(buf, &pos);
+            } else {
+                read_line_input("\n\tMinimum salary: ", buf, sizeof(buf));
+                if (!is_numeric(buf)) { printf("\n\tInvalid amount\n"); return; }
+                long lo = atol(buf), hi = LONG_MAX;
+                read_line_input("\n\tMaximum salary (blank = no limit): ", buf, sizeof(buf));
+                if (buf[0] && !is_numeric(buf)) { printf("\n\tInvalid amount\n"); return; }
+                if (buf[0]) hi = atol(buf);
+                n = store_find_salaries(lo, hi, &pos);
+            }
+            if (n > 0) view_pages(1, pos, n, 0, NULL);
+            else if (n == 0) printf("\n\tNo employee found.\n");
+            else printf("\n\tOut of memory\n");
+            free(pos);
+        } else if (opt == 2) {
+            read_line_input("\n\tEnter name: ", buf, sizeof(buf));
+            char key[MAX_NAME]; strncpy(key, buf, sizeof(key));
+            int found = 0;
+            for (int i = 0; i < count; ++i) {
+                if (strcasecmp(emps[i].name, key) == 0) {
+                    print_employees(&emps[i], 1);
+                    found++;
+                }
+            }
+            if (!found) printf("\n\tNo employee found.\n");
+        } else if (opt == 3) {
+            read_line_input("\n\tEnter ID: ", buf, sizeof(buf));
+            int i = store_find_employee(atoi(buf));
+            if (i >= 0) print_employees(&emps[i], 1);
+            else printf("\n\tNo employee found.\n");
+        } else if (opt == 4 || opt == 5) {
+            search_names(1, opt == 4);
+        } else {
+            printf("\n\tInvalid option\n");
+        }
+    } else if (ch == 2) {
+        if (store.cust.count == 0) {
+            printf("\n\tData file was empty\n");
+            return;
+        }
+        printf("\n\t1. By Account\n\t2. By aadhaar\n\t3. By Phone\n\t4. By Balance Range\n\t5. Top Balances\n"
+               "\t6. Name Starts With\n\t7. Similar Name\n");
+        char buf2[64];
+        read_line_input("\n\tEnter: ", buf2, sizeof(buf2));
+        int opt = atoi(buf2);
+        
+        if (opt == 1) {
+            read_line_input("\n\tEnter account number: ", buf2, sizeof(buf2));
+            int i = store_find_customer(atoi(buf2));
+            if (i >= 0) print_customer(&store.cust, i);
+            else printf("\n\tNo customer found.\n");
+        } else if (opt == 2) {
+            read_line_input("\n\tEnter aadhaar: ", buf2, sizeof(buf2));
+            int i = store_find_aadhaar(buf2);
+            if (i >= 0) print_customer(&store.cust, i);
+            else printf("\n\tNo customer found.\n");
+        } else if (opt == 3) {
+            read_line_input("\n\tEnter phone: ", buf2, sizeof(buf2));
+            int i = store_find_phone(buf2);
+            if (i >= 0) print_customer(&store.cust, i);
+            else printf("\n\tNo customer found.\n");
+        } else if (opt == 4 || opt == 5) {
+            long lo = LONG_MIN, hi = LONG_MAX;
+            int max = INT_MAX;
+            if (opt == 4) {
+                read_line_input("\n\tMinimum balance: ", buf2, sizeof(buf2));
+                if (!is_numeric(buf2)) { printf("\n\tInvalid amount\n"); return; }
+                lo = atol(buf2);
+                read_line_input("\n\tMaximum balance: ", buf2, sizeof(buf2));
+                if (!is_numeric(buf2)) { printf("\n\tInvalid amount\n"); return; }
+                hi = atol(buf2);
+            } else {
+                read_line_input("\n\tHow many accounts: ", buf2, sizeof(buf2));
+                if (!is_numeric(buf2) || atoi(buf2) <= 0) { printf("\n\tInvalid count\n"); return; }
+                max = atoi(buf2);
+            }
+            int *pos;
+            int n = store_find_balances(lo, hi, max, &pos);
+            if (n > 0) print_customer_set(&store.cust, pos, n);
+            else if (n == 0) printf("\n\tNo customer found.\n");
+            else printf("\n\tOut of memory\n");
+            free(pos);
+        } else if (opt == 6 || opt == 7) {
+            search_names(0, opt == 6);
+        } else {
+            printf("\n\tInvalid option\n");
+        }
+    } else {
+        printf("\n\tInvalid choice\n");
+    }
+}
+
+void delete_data() {
+    printf("\n\t1. Employee\n\t2. Customer\n");
+    char buf[64];
+    read_line_input("\n\tEnter choice: ", buf, sizeof(buf));
+    int ch = atoi(buf);
+    if (ch == 1) {
+        Employee *emps = store.emps; int count = store.emp_count;
+        if (count == 0) { printf("\n\tData file was empty\n"); return; }
+        printf("\n\t1. By ID\n\t2. By Name\n\t3. By Designation\n\t4. Delete all\n");
+        read_line_input("\n\tEnter option: ", buf, sizeof(buf));
+        int opt = atoi(buf);
+        
+        if (opt == 4) {
+            read_line_input("\n\tAre you sure to delete all? (YES/NO): ", buf, sizeof(buf));
+            if (strcasecmp(buf, "YES") == 0) {
+                store_drop_names();
+                store_free_employee_fields();
+                int *ids = malloc(count * sizeof(int));
+                for (int i = 0; i < count; ++i) {
+                    if (ids) ids[i] = emps[i].id;
+                    store_employee_removed(&emps[i]);
+                }
+                store_employees_removed(ids, count);
+                free(ids);
+                store.emp_count = 0;
+                store_reindex_employees();
+                store_index_employee_fields();
+                store_flush();
+                printf("\n\tAll deleted.\n");
+            }
+            else printf("\n\tCancelled.\n");
+        } else {
+            /* Collect the positions to drop in ascending order */
+            int *pos = NULL, removed = 0;
+            if (opt == 1 || opt == 2) {
+                read_line_input(opt == 1 ? "\n\tEnter ID to delete: " : "\n\tEnter name to delete: ",
+                                buf, sizeof(buf));
+                int id = atoi(buf);
+                if (!(pos = malloc(count * sizeof(int)))) { printf("\n\tOut of memory\n"); return; }
+                for (int i = 0; i < count; ++i)
+                    if (opt == 1 ? emps[i].id == id : strcasecmp(emps[i].name, buf) == 0) pos[removed++] = i;
+            } else if (opt == 3) {
+                read_line_input("\n\tEnter designation to delete: ", buf, sizeof(buf));
+                removed = store_find_designation(buf, &pos);
+                if (removed < 0) { printf("\n\tOut of memory\n"); return; }
+            } else {
+                printf("\n\tInvalid option\n");
+                return;
+            }
+            if (removed == 0) printf("\n\tNo matching records found.\n");
+            else {
+                store_remove_employees(pos, removed);
+                store_flush();
             }
-            break;
+            free(pos);
+            printf("\n\tDeleted %d records.\n", removed);
         }
+    } else if (ch == 2) {
+        int count = store.cust.count;
+        if (count == 0) { printf("\n\tData file was empty\n"); return; }
+        printf("\n\t1. By Account\n\t2. By Name\n\t3. By aadhaar\n\t4. Delete all\n");
+        read_line_input("\n\tEnter option: ", buf, sizeof(buf));
+        int opt = atoi(buf);
         
-        /* Validate salary - must be numeric */
-        while (1) {
-            read_line_input("\n\tEnter employee salary: ", e.salary, sizeof(e.salary));
-            if (strlen(e.salary) == 0) {
-                printf("\n\tSalary cannot be empty\n");
-                continue;
+        if (opt == 4) {
+            read_line_input("\n\tAre you sure to delete all? (YES/NO): ", buf, sizeof(buf));
+            if (strcasecmp(buf, "YES") == 0) {
+                store_drop_names();
+                for (int i = 0; i < count; ++i) store_customer_removed(i);
+                store.cust.count = 0;
+                store_reindex_customers();
+                store_flush();
+                printf("\n\tAll deleted.\n");
             }
-            if (!is_numeric(e.salary)) {
-                printf("\n\tInvalid salary - must contain only digits\n");
-                continue;
+            else printf("\n\tCancelled.\n");
+        } else {
+            /* Collect the positions to drop in ascending order; account and
+               aadhaar are unique keys, so their index gives at most one */
+            int *pos = NULL, removed = 0;
+            if (opt < 1 || opt > 3) {
+                printf("\n\tInvalid option\n");
+                return;
             }
-            break;
-        }
-        
-        /* Validate designation - must be alphabetic */
-        while (1) {
-            read_line_input("\n\tEnter employee designation: ", e.designation, sizeof(e.designation));
-            if (strlen(e.designation) == 0) {
-                printf("\n\tDesignation cannot be empty\n");
-                continue;
+            if (!(pos = malloc(count * sizeof(int)))) { printf("\n\tOut of memory\n"); return; }
+            if (opt == 1) {
+                read_line_input("\n\tEnter account to delete: ", buf, sizeof(buf));
+                int i = store_find_customer(atoi(buf));
+                if (i >= 0) pos[removed++] = i;
+            } else if (opt == 2) {
+                read_line_input("\n\tEnter name to delete: ", buf, sizeof(buf));
+                for (int i = 0; i < count; ++i)
+                    if (strcasecmp(ct_str(&store.cust, i, CF_NAME), buf) == 0) pos[removed++] = i;
+            } else {
+                read_line_input("\n\tEnter aadhaar to delete: ", buf, sizeof(buf));
+                int i = store_find_aadhaar(buf);
+                if (i >= 0) pos[removed++] = i;
             }
-            if (!is_alphabetic(e.designation)) {
-                printf("\n\tInvalid designation - must contain only letters and spaces\n");
-                continue;
+            if (removed == 0) printf("\n\tNo matching records found.\n");
+            else {
+                store_remove_customers(pos, removed);
+                store_flush();
             }
-            break;
+            free(pos);
+            printf("\n\tDeleted %d records.\n", removed);
+        }
+    } else {
+        printf("\n\tInvalid choice\n");
+    }
+}
+
+void update_data() {
+    printf("\n\t1. Employee\n\t2. Customer\n");
+    char buf[128];
+    read_line_input("\n\tEnter: ", buf, sizeof(buf));
+    int ch = atoi(buf);
+    if (ch == 1) {
+        Employee *emps = store.emps;
+        if (store.emp_count == 0) {
+            printf("\n\tData file was empty\n");
+            return;
         }
+        read_line_input("\n\tEnter Employee ID to update: ", buf, sizeof(buf));
+        int id = atoi(buf);
         
-        append_employee(&e);
-        printf("\n\tEmployee saved. ID: %d\n", e.id);
-    } else if (ch == 2) {
-        Customer *custs = NULL; int count = 0;
-        load_customers(&custs, &count);
-        int acc = count ? (custs[count-1].account + 1) : 1;
-        free(custs);
-        Customer c;
-        c.account = acc;
-        char balbuf[64];
-        while (1) {
-            /* Validate customer name - must be alphabetic */
-            read_line_input("\n\tEnter customer name: ", c.name, sizeof(c.name));
-            if (strlen(c.name) == 0) { 
-                printf("\n\tName cannot be empty\n"); 
-                continue; 
+        int i = store_find_employee(id);
+        if (i >= 0) {
+            printf("\n\tFound:\n");
+            print_employees(&emps[i], 1);
+            read_line_input("\n\tUpdate: 1.Name 2.Salary 3.Designation 4.All: ", buf, sizeof(buf));
+            int opt = atoi(buf);
+            if (opt == 1) { 
+                char temp[MAX_NAME];
+                while (1) {
+                    read_line_input("\n\tNew name: ", temp, sizeof(temp));
+                    if (strlen(temp) == 0 || !is_alphabetic(temp)) {
+                        printf("\n\tInvalid name - must contain only letters and spaces\n");
+                        continue;
+                    }
+                    store_set_employee_name(i, temp);
+                    break;
+                }
             }
-            if (!is_alphabetic(c.name)) {
-                printf("\n\tInvalid name - must contain only letters and spaces\n");
-                continue;
+            else if (opt == 2) { 
+                char temp[32];
+                while (1) {
+                    read_line_input("\n\tNew salary: ", temp, sizeof(temp));
+                    if (strlen(temp) == 0 || !is_numeric(temp)) {
+                        printf("\n\tInvalid salary - must contain only digits\n");
+                        continue;
+                    }
+                    store_set_employee_salary(i, temp);
+                    break;
+                }
             }
-            
-            /* Validate aadhaar - exactly 12 digits */
-            read_line_input("\n\tEnter aadhaar (12 digits): ", c.aadhaar, sizeof(c.aadhaar));
-            if (strlen(c.aadhaar) != 12 || !is_numeric(c.aadhaar)) { 
-                printf("\n\tInvalid aadhaar - must be exactly 12 digits\n"); 
-                continue;
+            else if (opt == 3) { 
+                char temp[MAX_DESIGN];
+                while (1) {
+                    read_line_input("\n\tNew designation: ", temp, sizeof(temp));
+                    if (strlen(temp) == 0 || !is_alphabetic(temp)) {
+                        printf("\n\tInvalid designation - must contain only letters and spaces\n");
+                        continue;
+                    }
+                    store_set_employee_designation(i, temp);
+                    break;
+                }
             }
-            
-            /* Validate phone - exactly 10 digits */
-            read_line_input("\n\tEnter phone (10 digits): ", c.phone, sizeof(c.phone));
-            if (strlen(c.phone) != 10 || !is_numeric(c.phone)) { 
-                printf("\n\tInvalid phone - must be exactly 10 digits\n"); 
-                continue;
+            else if (opt == 4) {
+                char temp[MAX_NAME];
+                /* Update name with validation */
+                while (1) {
+                    read_line_input("\n\tNew name: ", temp, sizeof(temp));
+                    if (strlen(temp) == 0 || !is_alphabetic(temp)) {
+                        printf("\n\tInvalid name - must contain only letters and spaces\n");
+                        continue;
+                    }
+                    store_set_employee_name(i, temp);
+                    break;
+                }
+                /* Update salary with validation */
+                while (1) {
+                    read_line_input("\n\tNew salary: ", temp, sizeof(temp));
+                    if (strlen(temp) == 0 || !is_numeric(temp)) {
+                        printf("\n\tInvalid salary - must contain only digits\n");
+                        continue;
+                    }
+                    store_set_employee_salary(i, temp);
+                    break;
+                }
+                /* Update designation with validation */
+                while (1) {
+                    read_line_input("\n\tNew designation: ", temp, sizeof(temp));
+                    if (strlen(temp) == 0 || !is_alphabetic(temp)) {
+                        printf("\n\tInvalid designation - must contain only letters and spaces\n");
+                        continue;
+                    }
+                    store_set_employee_designation(i, temp);
+                    break;
+                }
+            } else {
+                printf("\n\tInvalid option\n");
+                return;
             }
-            
-            /* Validate initial deposit - must be numeric and >= 1000 */
-            read_line_input("\n\tEnter initial deposit (min 1000 & max 50000): ", balbuf, sizeof(balbuf));
-            if (!is_numeric(balbuf)) {
-                printf("\n\tInvalid amount - must contain only digits\n");
-                continue;
+            store_employee_changed(i);
+            store_flush();
+        } else {
+            printf("\n\tEmployee not found\n");
+        }
+    } else if (ch == 2) {
+        if (store.cust.count == 0) {
+            printf("\n\tData file was empty\n");
+            return;
+        }
+        read_line_input("\n\tEnter Customer Account to update: ", buf, sizeof(buf));
+        int acc = atoi(buf);
+        
+        int i = store_find_customer(acc);
+        if (i >= 0) {
+            printf("\n\tFound:\n");
+            print_customer(&store.cust, i);
+            read_line_input("\n\tUpdate: 1.Name 2.aadhaar 3.Phone 4.Address 5.Balance 6.All: ", buf, sizeof(buf));
+            int opt = atoi(buf);
+            long before = store.cust.hot[i].balance;
+            if (opt == 1) {
+                char temp[MAX_NAME];
+                while (1) {
+                    read_line_input("\n\tNew name: ", temp, sizeof(temp));
+                    if (strlen(temp) == 0 || !is_alphabetic(temp)) {
+                        printf("\n\tInvalid name - must contain only letters and spaces\n");
+                        continue;
+                    }
+                    store_set_customer_name(i, temp);
+                    break;
+                }
             }
-            long bal = atol(balbuf);
-            if (bal < 1000) { 
-                printf("\n\tDeposit must be at least 1000\n"); 
-                continue;
+            else if (opt == 2) {
+                char temp[MAX_AAD];
+                while (1) {
+                    read_line_input("\n\tNew aadhaar: ", temp, sizeof(temp));
+                    if (strlen(temp) != 12 || !is_numeric(temp)) {
+                        printf("\n\tInvalid aadhaar - must be exactly 12 digits\n");
+                        continue;
+                    }
+                    if (store_set_customer_aadhaar(i, temp) != 0) {
+                        printf("\n\tAadhaar already registered to another account\n");
+                        continue;
+                    }
+                    break;
+                }
             }
-            if (bal > 50000) { 
-                printf("\n\tDeposit cannot exceed 50000\n"); 
-                continue;
+            else if (opt == 3) {
+                char temp[MAX_PHONE];
+                while (1) {
+                    read_line_input("\n\tNew phone: ", temp, sizeof(temp));
+                    if (strlen(temp) != 10 || !is_numeric(temp)) {
+                        printf("\n\tInvalid phone - must be exactly 10 digits\n");
+                        continue;
+                    }
+                    if (store_set_customer_phone(i, temp) != 0) {
+                        printf("\n\tPhone already registered to another account\n");
+                        continue;
+                    }
+                    break;
+                }
             }
-            c.balance = bal;
-            
-            /* Validate address - cannot be empty */
-            read_line_input("\n\tEnter address: ", c.address, sizeof(c.address));
-            if (strlen(c.address) == 0) { 
-                printf("\n\tAddress cannot be empty\n"); 
-                continue; 
+            else if (opt == 4) {
+                char temp[MAX_ADDR];
+                while (1) {
+                    read_line_input("\n\tNew address: ", temp, sizeof(temp));
+                    if (strlen(temp) == 0) {
+                        printf("\n\tAddress cannot be empty\n");
+                        continue;
+                    }
+                    ct_set(&store.cust, i, CF_ADDRESS, temp);
+                    break;
+                }
             }
-            
-            append_customer(&c);
-            printf("\n\tCustomer saved. Account: %d  Balance: %ld\n", c.account, c.balance);
-            break;
+            else if (opt == 5) {
+                char temp[64];
+                while (1) {
+                    read_line_input("\n\tNew balance: ", temp, sizeof(temp));
+                    if (!is_numeric(temp)) {
+                        printf("\n\tInvalid balance - must contain only digits\n");
+                        continue;
+                    }
+                    store_set_balance(i, atol(temp));
+                    break;
+                }
+            } else if (opt == 6) {
+                char temp[MAX_ADDR];
+                /* Update name with validation */
+                while (1) {
+                    read_line_input("\n\tNew name: ", temp, sizeof(temp));
+                    if (strlen(temp) == 0 || !is_alphabetic(temp)) {
+                        printf("\n\tInvalid name - must contain only letters and spaces\n");
+                        continue;
+                    }
+                    store_set_customer_name(i, temp);
+                    break;
+                }
+                /* Update aadhaar with validation */
+                while (1) {
+                    read_line_input("\n\tNew aadhaar: ", temp, sizeof(temp));
+                    if (strlen(temp) != 12 || !is_numeric(temp)) {
+                        printf("\n\tInvalid aadhaar - must be exactly 12 digits\n");
+                        continue;
+                    }
+                    if (store_set_customer_aadhaar(i, temp) != 0) {
+                        printf("\n\tAadhaar already registered to another account\n");
+                        continue;
+                    }
+                    break;
+                }
+                /* Update phone with validation */
+                while (1) {
+                    read_line_input("\n\tNew phone: ", temp, sizeof(temp));
+                    if (strlen(temp) != 10 || !is_numeric(temp)) {
+                        printf("\n\tInvalid phone - must be exactly 10 digits\n");
+                        continue;
+                    }
+                    if (store_set_customer_phone(i, temp) != 0) {
+                        printf("\n\tPhone already registered to another account\n");
+                        continue;
+                    }
+                    break;
+                }
+                /* Update address with validation */
+                while (1) {
+                    read_line_input("\n\tNew address: ", temp, sizeof(temp));
+                    if (strlen(temp) == 0) {
+                        printf("\n\tAddress cannot be empty\n");
+                        continue;
+                    }
+                    ct_set(&store.cust, i, CF_ADDRESS, temp);
+                    break;
+                }
+            } else {
+                printf("\n\tInvalid option\n");
+                return;
+            }
+            store_customer_changed(i, before);
+            store_flush();
+        } else {
+            printf("\n\tCustomer not found\n");
+        }
+    } else {
+        printf("\n\tInvalid choice\n");
+    }
+}
+
+void create_export() {
+    printf("\n\t1. Export Employees\n\t2. Export Customers\n");
+    char buf[128];
+    read_line_input("\n\tEnter: ", buf, sizeof(buf));
+    int ch = atoi(buf);
+    
+    if (ch == 1 || ch == 2) {
+        int count = ch == 1 ? store.emp_count : store.cust.count;
+        if (count == 0) {
+            printf("\n\tData file was empty\n");
+            return;
+        }
+        static const char *const ext[] = { "txt", "csv", "jsonl", "txt" };
+        read_line_input("\n\tFormat:\n\t1. Text\n\t2. CSV\n\t3. JSON Lines\n\t4. Fixed width\n\tEnter: ",
+                        buf, sizeof(buf));
+        int format = atoi(buf) >= 1 && atoi(buf) <= 4 ? atoi(buf) - 1 : EXPORT_TEXT;
+        char columns[128];
+        printf("\n\tColumns: %s\n", ch == 1 ? "id, name, salary, designation"
+                                           : "account, name, aadhaar, phone, balance, address");
+        read_line_input("\tEnter, comma separated (blank = default): ", columns, sizeof(columns));
+        for (char *r = columns, *w = columns; ; ++r) {
+            if (*r != ' ') *w++ = *r;
+            if (!*r) break;
+        }
+        ExportSpec spec;
+        if (export_spec(&spec, ch == 1, export_formats[format], columns) != 0) {
+            printf("\n\tUnknown column\n");
+            return;
+        }
+        read_line_input("\n\tEnter file name (without ext): ", buf, sizeof(buf));
+        if (strlen(buf) == 0) { printf("\n\tInvalid file name\n"); return; }
+        char path[512];
+        snprintf(path, sizeof(path), "%s.%s", buf, ext[format]);
+        long rows = export_table(&spec, path);
+        if (rows < 0) {
+            printf("\n\tUnable to create file\n");
+            return;
+        }
+        printf("\n\tCreated %s file at %s (%ld rows)\n", ch == 1 ? "employee" : "customer", path, rows);
+    } else {
+        printf("\n\tInvalid choice\n");
+    }
+}
+
+void withdraw_amount() {
+    char buf[64];
+    read_line_input("\n\tEnter account number: ", buf, sizeof(buf));
+    int acc = atoi(buf);
+    if (store.cust.count == 0) {
+        printf("\n\tData file was empty\n");
+        return;
+    }
+    int i = store_find_customer(acc);
+    if (i < 0) {
+        printf("\n\tAccount not found\n");
+        return;
+    }
+    CustHot *c = &store.cust.hot[i];
+    printf("\n\tAccount: %d  Name: %s\n", c->account, ct_str(&store.cust, i, CF_NAME));
+    printf("\n\tAvailable balance: %ld\n", c->balance);
+    if (c->balance <= MIN_BALANCE) { printf("\n\t%s\n", withdraw_error(c->balance, 0)); return; }
+    
+    read_line_input("\n\tEnter amount to withdraw: ", buf, sizeof(buf));
+    if (!is_numeric(buf)) {
+        printf("\n\tInvalid amount.\n");
+        return;
+    }
+    long amount = atol(buf);
+    const char *err = withdraw_error(c->balance, amount);
+    if (err) {
+        printf("\n\t%s\n", err);
+        return;
+    }
+    
+    read_line_input("\n\tConfirm withdraw (YES/NO): ", buf, sizeof(buf));
+    if (strcasecmp(buf, "YES") == 0) {
+        if (store_post(i, -amount) != 0) {
+            printf("\n\tUnable to record transaction\n");
+            return;
+        }
+        printf("\n\tWithdrawn. Remaining balance: %ld\n", c->balance);
+    } else {
+        printf("\n\tCancelled.\n");
+    }
+}
+
+void deposit_amount() {
+    char buf[64];
+    read_line_input("\n\tEnter account number: ", buf, sizeof(buf));
+    int acc = atoi(buf);
+    if (store.cust.count == 0) {
+        printf("\n\tData file was empty\n");
+        return;
+    }
+    int i = store_find_customer(acc);
+    if (i < 0) {
+        printf("\n\tAccount not found\n");
+        return;
+    }
+    CustHot *c = &store.cust.hot[i];
+    printf("\n\tAccount: %d  Name: %s\n", c->account, ct_str(&store.cust, i, CF_NAME));
+    printf("\n\tAvailable balance: %ld\n", c->balance);
+    printf("\n\tNote: deposit min 1000, max 50000\n");
+    
+    read_line_input("\n\tEnter amount to deposit: ", buf, sizeof(buf));
+    if (!is_numeric(buf)) {
+        printf("\n\tInvalid amount\n");
+        return;
+    }
+    long amount = atol(buf);
+    const char *err = deposit_error(amount);
+    if (err) { 
+        printf("\n\t%s\n", err); 
+        return; 
+    }
+    
+    read_line_input("\n\tConfirm deposit (YES/NO): ", buf, sizeof(buf));
+    if (strcasecmp(buf, "YES") == 0) {
+        if (store_post(i, amount) != 0) {
+            printf("\n\tUnable to record transaction\n");
+            return;
         }
+        printf("\n\tDeposited. New balance: %ld\n", c->balance);
+    } else {
+        printf("\n\tCancelled.\n");
+    }
+}
+
+/* ============================================================================
+   SERVER
+   ============================================================================ */
+
+/* `serve` keeps the store loaded and answers teller terminals on a Unix
+   domain socket (and optionally on 127.0.0.1 TCP) from one epoll loop, so
+   the store is only ever touched by one thread. Requests and responses are
+   single lines, fields separated by '|' as in batch files:
+
+     G|account  A|aadhaar  P|phone        OK|account|name|aadhaar|phone|balance|address
+     N|prefix[|max]                       OK|k, then k lines account|name|...
+     C|name|aadhaar|phone|deposit|address OK|account
+     U|account|FIELD|value                OK  (FIELD: name, aadhaar, phone, address)
+     X|account                            OK  (deletes the customer)
+     D|account|amount  W|account|amount   OK|balance
+     I                                    OK|customers|next_account
+     E|file[|format[|columns]]            OK|rows  (customer export, see below)
+
+   Failures answer ERR|message. A posting is applied at once and queued for
+   the GROUP COMMIT without waiting; its reply, and every reply after it on
+   the same connection, is held back until the committer signals the batch
+   durable on an eventfd. The loop never sleeps in fdatasync and postings
+   from all terminals share commits. A delete is journaled and answered
+   the same way. An update is not journaled: it marks the checkpoint due
+   and its reply is held until the checkpoint has rewritten the shard.
+   A due checkpoint waits for the first SERVER_IDLE_MS without requests,
+   or SERVER_CHECKPOINT_WAIT_MS once a reply is held for it. One that fails
+   stays due, answers the replies held for it with an error and is retried
+   after twice the idle time, up to SERVER_RETRY_MS.
+   An export is written by a thread of its own from a SNAPSHOT, into the
+   server's directory, while the loop goes on serving. Until it finishes,
+   requests that add, edit or delete customers are refused. */
+#define SERVER_SOCKET "banking.sock"
+#define SERVER_EVENTS 256
+#define SERVER_IDLE_MS 50
+#define SERVER_CHECKPOINT_WAIT_MS 1000
+#define SERVER_RETRY_MS 5000
+#define SERVER_PREFIX_ROWS 20
+#define SERVER_PREFIX_MAX 1000
+
+typedef struct {
+    int fd;
+    char in[MAX_LINE];
+    size_t in_len;
+    char *out;
+    size_t out_len, out_cap;
+    size_t held_from;       /* output from here waits for held_seq and held_checkpoint */
+    uint64_t held_seq;      /* 0 = nothing held */
+    uint64_t held_checkpoint; /* checkpoint number it waits for, 0 = none */
+    size_t export_at;       /* where the reply to a running export goes */
+    int export_wait;        /* output from export_at waits for the export */
+    int eof;                /* peer sent everything; close once answered */
+    int want_out;           /* EPOLLOUT is registered */
+    long id;                /* connection number, never reused */
+} Conn;
+
+typedef struct {
+    char path[256];
+    ExportSpec spec;
+    long rows;
+    int done_fd;            /* eventfd bumped when the export is written */
+} ServerExport;
+
+typedef struct {
+    int epfd, unix_fd, tcp_fd, notify_fd, signal_fd;
+    Conn **conns;           /* by fd */
+    int conns_cap;
+    long accepted, requests;
+    ServerExport export;
+    pthread_t export_thread;
+    int exporting;
+    long export_conn;       /* id of the connection waiting for it */
+    uint64_t checkpoints;   /* checkpoints the loop has run */
+    uint64_t checkpoint_asked; /* highest held_checkpoint handed out */
+    uint64_t checkpoint_by; /* metric_now() by which a held one must run */
+    int idle_ms;            /* wait before a due checkpoint, grows on failure */
+} Server;
+
+static void conn_printf(Conn *c, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void conn_printf(Conn *c, const char *fmt, ...) {
+    va_list ap;
+    for (;;) {
+        size_t room = c->out_cap - c->out_len;
+        va_start(ap, fmt);
+        int n = vsnprintf(c->out + c->out_len, room, fmt, ap);
+        va_end(ap);
+        if (n < 0) return;
+        if ((size_t)n < room) { c->out_len += n; return; }
+        size_t cap = c->out_cap ? c->out_cap * 2 : 4096;
+        while (cap - c->out_len <= (size_t)n) cap *= 2;
+        char *grown = realloc(c->out, cap);
+        if (!grown) return;
+        c->out = grown;
+        c->out_cap = cap;
+    }
+}
+
+static void server_close(Server *s, Conn *c) {
+    epoll_ctl(s->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    s->conns[c->fd] = NULL;
+    free(c->out);
+    free(c);
+}
+
+/* Send what is not held back. Returns -1 if the connection is gone or done. */
+static int conn_flush(Server *s, Conn *c) {
+    size_t limit = c->held_seq || c->held_checkpoint ? c->held_from : c->out_len, sent = 0;
+    if (c->export_wait && c->export_at < limit) limit = c->export_at;
+    while (sent < limit) {
+        ssize_t n = send(c->fd, c->out + sent, limit - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n <= 0) return -1;
+        sent += n;
+    }
+    if (sent > 0) {
+        memmove(c->out, c->out + sent, c->out_len - sent);
+        c->out_len -= sent;
+        if (c->held_seq || c->held_checkpoint) c->held_from -= sent;
+        if (c->export_wait) c->export_at -= sent;
+    }
+    int blocked = sent < limit;
+    if (blocked != c->want_out) {
+        struct epoll_event ev = { .events = (c->eof ? 0 : EPOLLIN) | (blocked ? EPOLLOUT : 0), .data.fd = c->fd };
+        epoll_ctl(s->epfd, EPOLL_CTL_MOD, c->fd, &ev);
+        c->want_out = blocked;
+    }
+    if (c->eof && c->out_len == 0 && !c->export_wait) return -1;
+    return 0;
+}
+
+static void server_customer(Conn *c, int i) {
+    Customer cu;
+    ct_get(&store.cust, i, &cu);
+    conn_printf(c, "%d|%s|%s|%s|%ld|%s\n", cu.account, cu.name, cu.aadhaar, cu.phone, cu.balance, cu.address);
+}
+
+/* Hold c's output from here until the commit of record seq */
+static void conn_hold_commit(Conn *c, uint64_t seq) {
+    if (!c->held_seq && !c->held_checkpoint) c->held_from = c->out_len;
+    c->held_seq = seq;
+}
+
+/* Hold c's output from here until the next checkpoint, and make one due */
+static void conn_hold_checkpoint(Server *s, Conn *c) {
+    if (!c->held_seq && !c->held_checkpoint) c->held_from = c->out_len;
+    if (s->checkpoint_asked == s->checkpoints)
+        s->checkpoint_by = metric_now() + (uint64_t)SERVER_CHECKPOINT_WAIT_MS * 1000000U;
+    c->held_checkpoint = s->checkpoint_asked = s->checkpoints + 1;
+    store_checkpoint_soon();
+}
+
+/* Validate and create a customer like CREATE NEW; NULL on success */
+static const char *server_create(char **f, int *account) {
+    Customer c;
+    memset(&c, 0, sizeof(c));
+    if (strlen(f[1]) >= sizeof(c.name) || !is_alphabetic(f[1]))
+        return "Invalid name - must contain only letters and spaces";
+    if (strlen(f[2]) != 12 || !is_numeric(f[2])) return "Invalid aadhaar - must be exactly 12 digits";
+    if (store_find_aadhaar(f[2]) >= 0) return "Aadhaar already registered to another account";
+    if (strlen(f[3]) != 10 || !is_numeric(f[3])) return "Invalid phone - must be exactly 10 digits";
+    if (store_find_phone(f[3]) >= 0) return "Phone already registered to another account";
+    if (!is_numeric(f[4]) || strlen(f[4]) > 9 || deposit_error(atol(f[4])))
+        return "Invalid amount - deposit must be 1000 to 50000";
+    if (f[5][0] == '\0' || strlen(f[5]) >= sizeof(c.address)) return "Address cannot be empty";
+    c.account = store_next_account();
+    strcpy(c.name, f[1]);
+    strcpy(c.aadhaar, f[2]);
+    strcpy(c.phone, f[3]);
+    strcpy(c.address, f[5]);
+    c.balance = atol(f[4]);
+    if (store_add_customer(&c) != 0) return "Unable to save customer";
+    *account = c.account;
+    return NULL;
+}
+
+/* Change one field of record i like UPDATE DATA; NULL on success */
+static const char *server_update(int i, const char *field, const char *value) {
+    if (strcasecmp(field, "name") == 0) {
+        if (strlen(value) >= MAX_NAME || !is_alphabetic(value))
+            return "Invalid name - must contain only letters and spaces";
+        if (store_set_customer_name(i, value) != 0) return "Unable to save customer";
+    } else if (strcasecmp(field, "aadhaar") == 0) {
+        if (strlen(value) != 12 || !is_numeric(value)) return "Invalid aadhaar - must be exactly 12 digits";
+        if (store_set_customer_aadhaar(i, value) != 0) return "Aadhaar already registered to another account";
+    } else if (strcasecmp(field, "phone") == 0) {
+        if (strlen(value) != 10 || !is_numeric(value)) return "Invalid phone - must be exactly 10 digits";
+        if (store_set_customer_phone(i, value) != 0) return "Phone already registered to another account";
+    } else if (strcasecmp(field, "address") == 0) {
+        if (value[0] == '\0' || strlen(value) >= MAX_ADDR) return "Address cannot be empty";
+        if (ct_set(&store.cust, i, CF_ADDRESS, value) != 0) return "Unable to save customer";
     } else {
-        printf("\n\tInvalid choice\n");
+        return "Unknown field";
     }
+    store_customer_changed(i, store.cust.hot[i].balance);
+    return NULL;
 }
 
-void view_all() {
-    printf("\n\t1. View Employees\n\t2. View Customers\n");
-    char buf[32];
-    read_line_input("\n\tEnter choice: ", buf, sizeof(buf));
-    int ch = atoi(buf);
-    if (ch == 1) {
-        Employee *emps = NULL; int count = 0;
-        load_employees(&emps, &count);
-        if (count == 0) {
-            printf("\n\tData file was empty\n");
-            free(emps);
+static void *server_export_main(void *arg) {
+    ServerExport *x = arg;
+    x->rows = export_table(&x->spec, x->path);
+    uint64_t one = 1;
+    if (write(x->done_fd, &one, sizeof(one)) != sizeof(one)) {}
+    return NULL;
+}
+
+/* Start exporting customers to file (a plain name in the server's
+   directory) for connection c, as format (default text) with columns */
+static const char *server_export(Server *s, Conn *c, const char *file, const char *format, const char *columns) {
+    if (s->exporting) return "Export in progress";
+    if (file[0] == '\0' || file[0] == '.' || strchr(file, '/') || strlen(file) >= sizeof(s->export.path))
+        return "Invalid file name";
+    if (export_spec(&s->export.spec, 0, format, columns) != 0) return "Unknown format or column";
+    strcpy(s->export.path, file);
+    if (pthread_create(&s->export_thread, NULL, server_export_main, &s->export) != 0)
+        return "Unable to create file";
+    s->exporting = 1;
+    s->export_conn = c->id;
+    c->export_wait = 1;
+    c->export_at = c->out_len;
+    return NULL;
+}
+
+/* The export thread is done: answer whoever asked, if still connected */
+static void server_export_done(Server *s) {
+    pthread_join(s->export_thread, NULL);
+    s->exporting = 0;
+    for (int fd = 0; fd < s->conns_cap; ++fd) {
+        Conn *c = s->conns[fd];
+        if (!c || c->id != s->export_conn) continue;
+        /* Replies to later requests were queued behind it; slot it in before them */
+        char reply[64];
+        int len = s->export.rows >= 0 ? snprintf(reply, sizeof(reply), "OK|%ld\n", s->export.rows)
+                                      : snprintf(reply, sizeof(reply), "ERR|Unable to create file\n");
+        size_t tail = c->out_len - c->export_at;
+        conn_printf(c, "%s", reply);
+        if (c->out_len == c->export_at + tail + len) {
+            memmove(c->out + c->export_at + len, c->out + c->export_at, tail);
+            memcpy(c->out + c->export_at, reply, len);
+            if ((c->held_seq || c->held_checkpoint) && c->held_from >= c->export_at) c->held_from += len;
+        }
+        c->export_wait = 0;
+        if (conn_flush(s, c) != 0) server_close(s, c);
+    }
+}
+
+/* Answer one request line into c's output */
+static void server_request(Server *s, Conn *c, char *line) {
+    char *f[8];
+    int n = 0;
+    f[n++] = line;
+    for (char *p = line; *p; ++p) {
+        if (*p != '|') continue;
+        if (n == 8) { conn_printf(c, "ERR|malformed request\n"); return; }
+        *p = '\0';
+        f[n++] = p + 1;
+    }
+    char op = (char)toupper((unsigned char)f[0][0]);
+    if (f[0][0] == '\0' || f[0][1] != '\0') op = '?';
+    const char *err = NULL;
+    int i = -1;
+    if ((op == 'G' || op == 'U' || op == 'X' || op == 'D' || op == 'W') && n > 1) {
+        i = is_numeric(f[1]) && strlen(f[1]) <= 9 ? store_find_customer(atoi(f[1])) : -1;
+        if (i < 0) { conn_printf(c, "ERR|Customer not found\n"); return; }
+    }
+    if (s->exporting && (op == 'C' || op == 'U' || op == 'X')) {
+        conn_printf(c, "ERR|Export in progress\n");
+        return;
+    }
+    switch (op) {
+        case 'I':
+            if (n != 1) break;
+            conn_printf(c, "OK|%d|%d\n", store.cust.count, store_next_account());
+            return;
+        case 'G': case 'A': case 'P':
+            if (n != 2) break;
+            if (op == 'A') i = store_find_aadhaar(f[1]);
+            if (op == 'P') i = store_find_phone(f[1]);
+            if (i < 0) { conn_printf(c, "ERR|Customer not found\n"); return; }
+            conn_printf(c, "OK|");
+            server_customer(c, i);
+            return;
+        case 'N': {
+            if (n != 2 && n != 3) break;
+            int max = n == 3 && is_numeric(f[2]) ? atoi(f[2]) : SERVER_PREFIX_ROWS;
+            if (max > SERVER_PREFIX_MAX) max = SERVER_PREFIX_MAX;
+            int *pos;
+            int k = f[1][0] ? store_find_name_prefix(0, f[1], &pos) : -1;
+            if (k < 0) { conn_printf(c, "ERR|Invalid name prefix\n"); return; }
+            if (k > max) k = max;
+            conn_printf(c, "OK|%d\n", k);
+            for (int j = 0; j < k; ++j) server_customer(c, pos[j]);
+            free(pos);
             return;
         }
-        read_line_input("\n\t1. Ascending\n\t2. Descending\n\tEnter: ", buf, sizeof(buf));
-        int order = atoi(buf);
-        
-        if (order == 2) {
-            /* print reversed */
-            Employee *rev = malloc(count * sizeof(Employee));
-            for (int i = 0; i < count; ++i) rev[i] = emps[count-1-i];
-            print_employees(rev, count);
-            free(rev);
-        } else {
-            print_employees(emps, count);
+        case 'C': {
+            if (n != 6) break;
+            int account;
+            if ((err = server_create(f, &account)) == NULL) conn_printf(c, "OK|%d\n", account);
+            break;
         }
-        free(emps);
-    } else if (ch == 2) {
-        Customer *custs = NULL; int count = 0;
-        load_customers(&custs, &count);
-        if (count == 0) {
-            printf("\n\tData file was empty\n");
-            free(custs);
-            return;
+        case 'E':
+            if (n < 2 || n > 4) break;
+            err = server_export(s, c, f[1], n > 2 ? f[2] : "text", n > 3 ? f[3] : NULL);
+            if (!err) return;   /* answered by server_export_done */
+            break;
+        case 'U':
+            if (n != 4) break;
+            if ((err = server_update(i, f[2], f[3])) != NULL) break;
+            conn_hold_checkpoint(s, c);
+            conn_printf(c, "OK\n");
+            break;
+        case 'X': {
+            if (n != 2) break;
+            if (store_remove_customers(&i, 1) != 0) { err = "Unable to delete customer"; break; }
+            /* The tombstone is journaled; a failed enqueue leaves it to the checkpoint */
+            uint64_t seq = gc_enqueued(&store.gc), durable;
+            if (gc_durable(&store.gc, &durable) != 0 || seq > durable) conn_hold_commit(c, seq);
+            if (store.binary || store.custs_dirty) conn_hold_checkpoint(s, c);
+            conn_printf(c, "OK\n");
+            break;
         }
-        read_line_input("\n\t1. Ascending\n\t2. Descending\n\tEnter: ", buf, sizeof(buf));
-        int order = atoi(buf);
-        
-        if (order == 2) {
-            Customer *rev = malloc(count * sizeof(Customer));
-            for (int i = 0; i < count; ++i) rev[i] = custs[count-1-i];
-            print_customers(rev, count);
-            free(rev);
-        } else {
-            print_customers(custs, count);
+        case 'D': case 'W': {
+            if (n != 3) break;
+            long amount = is_numeric(f[2]) && strlen(f[2]) <= 9 ? atol(f[2]) : -1;
+            long balance = store.cust.hot[i].balance;
+            err = op == 'W' ? withdraw_error(balance, amount) : deposit_error(amount);
+            if (err) break;
+            uint64_t seq = store_post_enqueue(i, op == 'W' ? -amount : amount);
+            if (!seq) { err = "Unable to record transaction"; break; }
+            conn_hold_commit(c, seq);
+            conn_printf(c, "OK|%ld\n", store.cust.hot[i].balance);
+            return;
         }
-        free(custs);
-    } else {
-        printf("\n\tInvalid choice\n");
     }
+    if (err) conn_printf(c, "ERR|%s\n", err);
+    else if (op != 'C' && op != 'U' && op != 'X') conn_printf(c, "ERR|malformed request\n");
 }
 
-void search_data() {
-    printf("\n\t1. Search Employee\n\t2. Search Customer\n");
-    char buf[64];
-    read_line_input("\n\tEnter choice: ", buf, sizeof(buf));
-    int ch = atoi(buf);
-    if (ch == 1) {
-        Employee *emps = NULL; int count = 0;
-        load_employees(&emps, &count);
-        if (count == 0) {
-            printf("\n\tData file was empty\n");
-            free(emps);
-            return;
+/* Read what the peer sent and answer every complete line */
+static int conn_read(Server *s, Conn *c) {
+    while (!c->eof) {
+        ssize_t n = recv(c->fd, c->in + c->in_len, sizeof(c->in) - c->in_len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0) return -1;
+        if (n == 0) {
+            c->eof = 1;
+            struct epoll_event ev = { .events = c->want_out ? EPOLLOUT : 0, .data.fd = c->fd };
+            epoll_ctl(s->epfd, EPOLL_CTL_MOD, c->fd, &ev);
+            break;
         }
-        printf("\n\t1. By Designation\n\t2. By Name\n\t3. By ID\n");
-        read_line_input("\n\tEnter: ", buf, sizeof(buf));
-        int opt = atoi(buf);
-        
-        
-        if (opt == 1) {
-            read_line_input("\n\tEnter designation: ", buf, sizeof(buf));
-            char key[MAX_DESIGN]; strncpy(key, buf, sizeof(key));
-            int found = 0;
-            for (int i = 0; i < count; ++i) {
-                if (strcasecmp(emps[i].designation, key) == 0) {
-                    print_employees(&emps[i], 1);
-                    found++;
-                }
-            }
-            if (!found) printf("\n\tNo employee found.\n");
-        } else if (opt == 2) {
-            read_line_input("\n\tEnter name: ", buf, sizeof(buf));
-            char key[MAX_NAME]; strncpy(key, buf, sizeof(key));
-            int found = 0;
-            for (int i = 0; i < count; ++i) {
-                if (strcasecmp(emps[i].name, key) == 0) {
-                    print_employees(&emps[i], 1);
-                    found++;
-                }
-            }
-            if (!found) printf("\n\tNo employee found.\n");
-        } else if (opt == 3) {
-            read_line_input("\n\tEnter ID: ", buf, sizeof(buf));
-            int id = atoi(buf);
-            int found = 0;
-            for (int i = 0; i < count; ++i) {
-                if (emps[i].id == id) {
-                    print_employees(&emps[i], 1);
-                    found = 1; break;
-                }
-            }
-            if (!found) printf("\n\tNo employee found.\n");
+        c->in_len += n;
+        char *start = c->in, *nl;
+        while ((nl = memchr(start, '\n', c->in + c->in_len - start)) != NULL) {
+            *nl = '\0';
+            if (nl > start && nl[-1] == '\r') nl[-1] = '\0';
+            uint64_t t0 = metric_now();
+            server_request(s, c, start);
+            metric_record(M_SERVER_REQUEST, t0, 0, 0);
+            s->requests++;
+            start = nl + 1;
+        }
+        c->in_len -= start - c->in;
+        memmove(c->in, start, c->in_len);
+        if (c->in_len == sizeof(c->in)) {
+            conn_printf(c, "ERR|line too long\n");
+            c->eof = 1;
+            break;
+        }
+    }
+    return conn_flush(s, c);
+}
+
+/* Let out the replies whose postings are now durable and whose checkpoint
+   has run. If a commit or the checkpoint failed the held replies are
+   replaced by an error and the connection closed. */
+static void server_release(Server *s, int checkpoint_failed) {
+    uint64_t durable;
+    int failed = gc_durable(&store.gc, &durable) != 0;
+    for (int fd = 0; fd < s->conns_cap; ++fd) {
+        Conn *c = s->conns[fd];
+        if (!c || (!c->held_seq && !c->held_checkpoint)) continue;
+        const char *err = NULL;
+        if (failed && c->held_seq > durable) err = "Unable to record transaction";
+        else if (checkpoint_failed && c->held_checkpoint) err = "Unable to save customer";
+        if (err) {
+            c->out_len = c->held_from;
+            c->held_seq = c->held_checkpoint = 0;
+            conn_printf(c, "ERR|%s\n", err);
+            c->eof = 1;
         } else {
-            printf("\n\tInvalid option\n");
+            if (c->held_seq <= durable) c->held_seq = 0;
+            if (c->held_checkpoint <= s->checkpoints) c->held_checkpoint = 0;
+            if (c->held_seq || c->held_checkpoint) continue;
         }
-        free(emps);
-    } else if (ch == 2) {
-        Customer *custs = NULL; int count = 0;
-        load_customers(&custs, &count);
-        if (count == 0) {
-            printf("\n\tData file was empty\n");
-            free(custs);
-            return;
+        if (conn_flush(s, c) != 0) server_close(s, c);
+    }
+}
+
+/* Run the due checkpoint on the loop and answer the replies held for it.
+   A failed one stays due and is retried after a longer idle time. */
+static void server_checkpoint(Server *s) {
+    if (store_checkpoint_if_due() == 0) {
+        s->checkpoints++;
+        s->checkpoint_asked = s->checkpoints;
+        s->idle_ms = SERVER_IDLE_MS;
+        server_release(s, 0);
+        return;
+    }
+    s->idle_ms = s->idle_ms * 2 < SERVER_RETRY_MS ? s->idle_ms * 2 : SERVER_RETRY_MS;
+    fprintf(stderr, "Checkpoint failed; the journal is kept and it is retried in %d ms\n", s->idle_ms);
+    server_release(s, 1);
+    s->checkpoint_asked = s->checkpoints;
+}
+
+static int server_accept(Server *s, int lfd) {
+    for (;;) {
+        int fd = accept(lfd, NULL, NULL);
+        if (fd < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        if (fd >= s->conns_cap) {
+            int cap = s->conns_cap ? s->conns_cap : 64;
+            while (cap <= fd) cap *= 2;
+            Conn **grown = realloc(s->conns, cap * sizeof(Conn *));
+            if (!grown) { close(fd); continue; }
+            memset(grown + s->conns_cap, 0, (cap - s->conns_cap) * sizeof(Conn *));
+            s->conns = grown;
+            s->conns_cap = cap;
         }
-        printf("\n\t1. By Account\n\t2. By aadhaar\n\t3. By Phone\n");
-        char buf2[64];
-        read_line_input("\n\tEnter: ", buf2, sizeof(buf2));
-        int opt = atoi(buf2);
-        
-        if (opt == 1) {
-            read_line_input("\n\tEnter account number: ", buf2, sizeof(buf2));
-            int acc = atoi(buf2);
-            int found = 0;
-            for (int i = 0; i < count; ++i) {
-                if (custs[i].account == acc) { print_customers(&custs[i], 1); found = 1; break; }
-            }
-            if (!found) printf("\n\tNo customer found.\n");
-        } else if (opt == 2) {
-            read_line_input("\n\tEnter aadhaar: ", buf2, sizeof(buf2));
-            int found = 0;
-            for (int i = 0; i < count; ++i) {
-                if (strcmp(custs[i].aadhaar, buf2) == 0) { print_customers(&custs[i], 1); found = 1; break; }
-            }
-            if (!found) printf("\n\tNo customer found.\n");
-        } else if (opt == 3) {
-            read_line_input("\n\tEnter phone: ", buf2, sizeof(buf2));
-            int found = 0;
-            for (int i = 0; i < count; ++i) {
-                if (strcmp(custs[i].phone, buf2) == 0) { print_customers(&custs[i], 1); found = 1; break; }
+        Conn *c = calloc(1, sizeof(Conn));
+        struct epoll_event ev = { .events = EPOLLIN, .data.fd = fd };
+        if (!c || epoll_ctl(s->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            free(c);
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->id = ++s->accepted;
+        s->conns[fd] = c;
+    }
+}
+
+static int server_listen_unix(const char *path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    struct stat st;
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    strcpy(addr.sun_path, path);
+    /* The store lock is held, so a socket left here belongs to a dead server */
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) unlink(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int server_listen_tcp(int port) {
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port) };
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0), one = 1;
+    if (fd < 0) return -1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int server_watch(Server *s, int fd) {
+    struct epoll_event ev = { .events = EPOLLIN, .data.fd = fd };
+    return fd < 0 ? 0 : epoll_ctl(s->epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+/* Serve until SIGINT or SIGTERM, then flush and exit. port 0 = no TCP. */
+static int run_serve(const char *path, int port) {
+    Server s = { .epfd = -1, .unix_fd = -1, .tcp_fd = -1, .notify_fd = -1, .signal_fd = -1,
+                 .export.done_fd = -1, .idle_ms = SERVER_IDLE_MS };
+    sigset_t stop;
+    sigemptyset(&stop);
+    sigaddset(&stop, SIGINT);
+    sigaddset(&stop, SIGTERM);
+    /* Blocked before store_load so the commit thread inherits the mask */
+    pthread_sigmask(SIG_BLOCK, &stop, NULL);
+    if (store_load() != 0) {
+        fprintf(stderr, "Unable to load data files\n");
+        return 1;
+    }
+    int rc = 1;
+    s.epfd = epoll_create1(EPOLL_CLOEXEC);
+    s.notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    s.signal_fd = signalfd(-1, &stop, SFD_NONBLOCK | SFD_CLOEXEC);
+    s.export.done_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    s.unix_fd = server_listen_unix(path);
+    if (port > 0) s.tcp_fd = server_listen_tcp(port);
+    if (s.epfd < 0 || s.notify_fd < 0 || s.signal_fd < 0 || s.export.done_fd < 0 || s.unix_fd < 0 ||
+        (port > 0 && s.tcp_fd < 0) || server_watch(&s, s.unix_fd) != 0 || server_watch(&s, s.tcp_fd) != 0 ||
+        server_watch(&s, s.notify_fd) != 0 || server_watch(&s, s.signal_fd) != 0 ||
+        server_watch(&s, s.export.done_fd) != 0) {
+        fprintf(stderr, "Unable to listen on %s%s\n", path, port > 0 ? " or 127.0.0.1" : "");
+        goto done;
+    }
+    gc_set_notify(&store.gc, s.notify_fd);
+    fprintf(stderr, "Serving %d customers on %s", store.cust.count, path);
+    if (port > 0) fprintf(stderr, " and 127.0.0.1:%d", port);
+    fprintf(stderr, "\n");
+
+    struct epoll_event events[SERVER_EVENTS];
+    int running = 1;
+    while (running) {
+        int n = epoll_wait(s.epfd, events, SERVER_EVENTS, store.checkpoint_due ? s.idle_ms : -1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) goto done;
+        if (n == 0) server_checkpoint(&s);
+        for (int k = 0; k < n; ++k) {
+            int fd = events[k].data.fd;
+            if (fd == s.signal_fd) {
+                running = 0;
+            } else if (fd == s.notify_fd) {
+                uint64_t count;
+                if (read(fd, &count, sizeof(count)) != sizeof(count)) {}
+                server_release(&s, 0);
+            } else if (fd == s.export.done_fd) {
+                uint64_t count;
+                if (read(fd, &count, sizeof(count)) != sizeof(count)) {}
+                server_export_done(&s);
+            } else if (fd == s.unix_fd || fd == s.tcp_fd) {
+                server_accept(&s, fd);
+            } else if (fd < s.conns_cap && s.conns[fd]) {
+                Conn *c = s.conns[fd];
+                int bad = (events[k].events & (EPOLLERR | EPOLLHUP)) && !(events[k].events & EPOLLIN);
+                if (bad || conn_read(&s, c) != 0) server_close(&s, c);
             }
-            if (!found) printf("\n\tNo customer found.\n");
-        } else {
-            printf("\n\tInvalid option\n");
         }
-        free(custs);
+        /* Under steady load the loop is never idle; replies held for a
+           checkpoint must not wait for that */
+        if (n > 0 && s.checkpoint_asked > s.checkpoints && metric_now() >= s.checkpoint_by)
+            server_checkpoint(&s);
+    }
+    rc = 0;
+done:
+    if (s.exporting) server_export_done(&s);
+    gc_set_notify(&store.gc, -1);
+    /* Answer requests still waiting for their commit or checkpoint before going away */
+    if (gc_drain(&store.gc) == 0) {
+        for (int fd = 0; fd < s.conns_cap; ++fd) {
+            if (s.conns[fd]) s.conns[fd]->held_seq = 0;
+        }
+    }
+    int flushed = store_flush() == 0;
+    if (!flushed) rc = 1;
+    for (int fd = 0; fd < s.conns_cap; ++fd) {
+        if (!s.conns[fd]) continue;
+        if (flushed) s.conns[fd]->held_checkpoint = 0;
+        conn_flush(&s, s.conns[fd]);
+        server_close(&s, s.conns[fd]);
+    }
+    free(s.conns);
+    store_free();
+    if (s.unix_fd >= 0) unlink(path);
+    int fds[] = { s.epfd, s.unix_fd, s.tcp_fd, s.notify_fd, s.signal_fd, s.export.done_fd };
+    for (int k = 0; k < 6; ++k) {
+        if (fds[k] >= 0) close(fds[k]);
+    }
+    fprintf(stderr, "Served %ld requests on %ld connections\n", s.requests, s.accepted);
+    return rc;
+}
+
+/* ============================================================================
+   COMMAND LINE
+   ============================================================================ */
+
+/* Rewrite the current (text) tables, journal included, as binary files */
+static int convert_to_binary(void) {
+    if (access(CUST_BIN, F_OK) == 0) {
+        fprintf(stderr, "%s already exists\n", CUST_BIN);
+        return 1;
+    }
+    if (store_load() != 0 || store_checkpoint() != 0) {
+        fprintf(stderr, "Unable to load data files\n");
+        return 1;
+    }
+    BinFile emp_bin, cust_bin;
+    remove(EMP_BIN ".tmp");
+    remove(CUST_BIN ".tmp");
+    if (bin_open(&emp_bin, EMP_BIN ".tmp", "BNKEMP01", sizeof(BinEmployee)) != 0 ||
+        bin_open(&cust_bin, CUST_BIN ".tmp", "BNKCUS01", sizeof(BinCustomer)) != 0) {
+        fprintf(stderr, "Unable to create binary files\n");
+        store_free();
+        return 1;
+    }
+    int skipped = 0;
+    for (int i = 0; i < store.emp_count; ++i) {
+        const int32_t *slot = bin_slot(&emp_bin, store.emps[i].id);
+        if ((slot && *slot != 0) || bin_put_employee(&emp_bin, &store.emps[i]) != 0) skipped++;
+    }
+    for (int i = 0; i < store.cust.count; ++i) {
+        Customer c;
+        ct_get(&store.cust, i, &c);
+        const int32_t *slot = bin_slot(&cust_bin, c.account);
+        if ((slot && *slot != 0) || bin_put_customer(&cust_bin, &c) != 0) skipped++;
+    }
+    int rc = bin_sync(&emp_bin) == 0 && bin_sync(&cust_bin) == 0 ? 0 : 1;
+    printf("Converted %u employees and %u customers", emp_bin.hdr->count, cust_bin.hdr->count);
+    if (skipped) printf(" (%d records with duplicate or out-of-range keys skipped)", skipped);
+    printf("\n");
+    bin_close(&emp_bin);
+    bin_close(&cust_bin);
+    store_free();
+    if (rc == 0 && (rename(EMP_BIN ".tmp", EMP_BIN) != 0 || rename(CUST_BIN ".tmp", CUST_BIN) != 0)) rc = 1;
+    return rc;
+}
+
+/* Write the binary tables back out as text and switch back to the text backend */
+static int convert_to_text(void) {
+    if (access(CUST_BIN, F_OK) != 0) {
+        fprintf(stderr, "%s does not exist\n", CUST_BIN);
+        return 1;
+    }
+    if (store_load() != 0) {
+        fprintf(stderr, "Unable to load data files\n");
+        return 1;
+    }
+    int rc = 0;
+    if (save_employees(store.emps, store.emp_count) != 0 || save_customers(&store.cust) != 0)
+        rc = 1;
+    printf("Converted %d employees and %d customers\n", store.emp_count, store.cust.count);
+    store_free();
+    if (rc == 0) {
+        remove(CUST_JOURNAL);
+        remove(EMP_TOMBSTONES);
+        remove(EMP_BIN);
+        remove(CUST_BIN);
+    }
+    return rc;
+}
+
+/* Write both tables as COLUMNAR SNAPSHOTS; the data files stay in use */
+static int convert_to_columnar(void) {
+    if (store_load() != 0) {
+        fprintf(stderr, "Unable to load data files\n");
+        return 1;
+    }
+    long emp_bytes, cust_bytes;
+    int rc = 0;
+    if (col_write_employees(EMP_COL, store.emps, store.emp_count, &emp_bytes) != 0 ||
+        col_write_customers(CUST_COL, &store.cust, &cust_bytes) != 0) {
+        fprintf(stderr, "Unable to write %s/%s\n", EMP_COL, CUST_COL);
+        rc = 1;
     } else {
-        printf("\n\tInvalid choice\n");
+        printf("Converted %d employees and %d customers (%s %ld bytes, %s %ld bytes)\n", store.emp_count,
+               store.cust.count, EMP_COL, emp_bytes, CUST_COL, cust_bytes);
     }
+    store_free();
+    return rc;
 }
 
-void delete_data() {
-    printf("\n\t1. Employee\n\t2. Customer\n");
-    char buf[64];
-    read_line_input("\n\tEnter choice: ", buf, sizeof(buf));
-    int ch = atoi(buf);
-    if (ch == 1) {
-        Employee *emps = NULL; int count = 0;
-        load_employees(&emps, &count);
-        if (count == 0) { printf("\n\tData file was empty\n"); free(emps); return; }
-        printf("\n\t1. By ID\n\t2. By Name\n\t3. By Designation\n\t4. Delete all\n");
-        read_line_input("\n\tEnter option: ", buf, sizeof(buf));
-        int opt = atoi(buf);
-        
-        if (opt == 4) {
-            read_line_input("\n\tAre you sure to delete all? (YES/NO): ", buf, sizeof(buf));
-            if (strcasecmp(buf, "YES") == 0) { save_employees(NULL, 0); printf("\n\tAll deleted.\n"); }
-            else printf("\n\tCancelled.\n");
+/* Replace the text tables with the contents of the columnar snapshots */
+static int convert_from_columnar(void) {
+    if (access(CUST_BIN, F_OK) == 0) {
+        fprintf(stderr, "%s is in use; convert to-text first\n", CUST_BIN);
+        return 1;
+    }
+    Employee *emps;
+    int nemp;
+    CustTable t;
+    if (col_load_employees(EMP_COL, &emps, &nemp) != 0) {
+        fprintf(stderr, "Unable to read %s\n", EMP_COL);
+        return 1;
+    }
+    if (col_load_customers(CUST_COL, &t) != 0) {
+        fprintf(stderr, "Unable to read %s\n", CUST_COL);
+        free(emps);
+        return 1;
+    }
+    int rc = 1;
+    if (store_lock_files() == 0) {
+        if (save_employees(emps, nemp) == 0 && save_customers(&t) == 0) {
+            remove(CUST_JOURNAL);
+            remove(EMP_TOMBSTONES);
+            printf("Converted %d employees and %d customers\n", nemp, t.count);
+            rc = 0;
         } else {
-            Employee *newarr = malloc(count * sizeof(Employee));
-            int newc = 0, removed = 0;
-            if (opt == 1) {
-                read_line_input("\n\tEnter ID to delete: ", buf, sizeof(buf));
-                int id = atoi(buf);
-                for (int i = 0; i < count; ++i) {
-                    if (emps[i].id == id) { removed++; continue; }
-                    newarr[newc++] = emps[i];
-                }
-            } else if (opt == 2) {
-                read_line_input("\n\tEnter name to delete: ", buf, sizeof(buf));
-                for (int i = 0; i < count; ++i) {
-                    if (strcasecmp(emps[i].name, buf) == 0) { removed++; continue; }
-                    newarr[newc++] = emps[i];
-                }
-            } else if (opt == 3) {
-                read_line_input("\n\tEnter designation to delete: ", buf, sizeof(buf));
-                for (int i = 0; i < count; ++i) {
-                    if (strcasecmp(emps[i].designation, buf) == 0) { removed++; continue; }
-                    newarr[newc++] = emps[i];
-                }
-            } else {
-                printf("\n\tInvalid option\n");
-                free(newarr); free(emps);
-                return;
+            fprintf(stderr, "Unable to write data files\n");
+        }
+        close(store.lock_fd);
+        store.lock_fd = -1;
+    }
+    free(emps);
+    ct_free(&t);
+    return rc;
+}
+
+/* Apply a file of postings in one pass over the in-memory accounts.
+   Input lines are "D|account|amount" or "W|account|amount"; each gets one
+   result line "lineno|type|account|amount|OK|balance" or
+   "lineno|...|REJECTED|reason". Postings run on the TRANSACTION ENGINE
+   (postings to one account keep file order) and everything is persisted
+   once at the end. */
+typedef struct {
+    long lineno;
+    char *text;             /* raw line of a malformed one, for its report line */
+    Transaction tx;
+} BatchLine;
+
+static void batch_free(BatchLine *lines, long n) {
+    for (long k = 0; k < n; ++k) free(lines[k].text);
+    free(lines);
+}
+
+static int run_batch(const char *in_path, const char *report_path) {
+    FILE *in = fopen(in_path, "r");
+    if (!in) { fprintf(stderr, "Unable to open %s\n", in_path); return 1; }
+    FILE *rep = report_path ? fopen(report_path, "w") : stdout;
+    if (!rep) { fprintf(stderr, "Unable to create %s\n", report_path); fclose(in); return 1; }
+    if (store_load() != 0) {
+        fprintf(stderr, "Unable to load data files\n");
+        fclose(in);
+        if (rep != stdout) fclose(rep);
+        return 1;
+    }
+    BatchLine *lines = NULL;
+    long n = 0, cap = 0;
+    char line[MAX_LINE];
+    long lineno = 0;
+    int oom = 0;
+    while (!oom && fgets(line, sizeof(line), in)) {
+        lineno++;
+        trim_newline(line);
+        if (line[0] == '\0') continue;
+        if (n == cap) {
+            long grown_cap = cap ? cap * 2 : 1024;
+            BatchLine *grown = realloc(lines, grown_cap * sizeof(BatchLine));
+            if (!grown) { oom = 1; break; }
+            lines = grown;
+            cap = grown_cap;
+        }
+        BatchLine *b = &lines[n++];
+        memset(b, 0, sizeof(*b));
+        b->lineno = lineno;
+        char *parts[3] = {0};
+        int idx = 0;
+        char *p = line;
+        parts[idx++] = p;
+        while (*p && idx < 3) {
+            if (*p == '|') { *p = '\0'; parts[idx++] = p+1; }
+            p++;
+        }
+        b->tx.type = (char)toupper((unsigned char)parts[0][0]);
+        if (idx < 3 || parts[0][1] != '\0' || (b->tx.type != 'D' && b->tx.type != 'W')) {
+            b->tx.error = "malformed line";
+            for (int k = 1; k < idx; ++k) parts[k][-1] = '|';
+            if (!(b->text = strdup(line))) oom = 1;
+        } else if (!is_numeric(parts[2])) {
+            b->tx.error = "Invalid amount.";
+        }
+        b->tx.account = idx > 1 ? atoi(parts[1]) : 0;
+        b->tx.amount = idx > 2 ? atol(parts[2]) : 0;
+    }
+    fclose(in);
+    if (oom) {
+        fprintf(stderr, "Out of memory at line %ld of %s; nothing was applied\n", lineno, in_path);
+        batch_free(lines, n);
+        store_free();
+        if (rep != stdout) fclose(rep);
+        return 1;
+    }
+
+    TxEngine engine;
+    if (tx_engine_start(&engine, online_cpus(), 1) != 0) {
+        fprintf(stderr, "Unable to start worker threads\n");
+        batch_free(lines, n);
+        store_free();
+        if (rep != stdout) fclose(rep);
+        return 1;
+    }
+    for (long k = 0; k < n; ++k)
+        if (!lines[k].tx.error) tx_submit(&engine, &lines[k].tx);
+    tx_engine_stop(&engine);
+
+    long applied = 0, rejected = 0;
+    for (long k = 0; k < n; ++k) {
+        const BatchLine *b = &lines[k];
+        if (b->tx.error && strcmp(b->tx.error, "malformed line") == 0)
+            fprintf(rep, "%ld|%s|REJECTED|%s\n", b->lineno, b->text, b->tx.error);
+        else if (b->tx.error)
+            fprintf(rep, "%ld|%c|%d|%ld|REJECTED|%s\n", b->lineno, b->tx.type, b->tx.account, b->tx.amount, b->tx.error);
+        else
+            fprintf(rep, "%ld|%c|%d|%ld|OK|%ld\n", b->lineno, b->tx.type, b->tx.account, b->tx.amount, b->tx.balance);
+        if (b->tx.error) rejected++; else applied++;
+    }
+    batch_free(lines, n);
+    int rc = store_flush() == 0 ? 0 : 1;
+    if (rep != stdout) fclose(rep);
+    store_free();
+    fprintf(stderr, "Applied %ld, rejected %ld%s\n", applied, rejected, rc ? " (save failed)" : "");
+    return rc;
+}
+
+/* Commands that build their own data set run in a fresh directory under
+   /tmp, so the data files of the current directory are never touched */
+static int scratch_enter(char *cwd, size_t size, char *dir) {
+    if (!getcwd(cwd, size) || !mkdtemp(dir) || chdir(dir) != 0) {
+        fprintf(stderr, "Unable to create scratch directory\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void scratch_clean(void) {
+    remove(CUST_FILE);
+    remove(EMP_FILE);
+    remove(CUST_JOURNAL);
+    remove(EMP_TOMBSTONES);
+    remove(META_FILE);
+    remove(LOCK_FILE);
+    DIR *d = opendir(".");
+    if (!d) return;
+    struct dirent *e;
+    uint64_t segment;
+    while ((e = readdir(d)) != NULL)
+        if (feed_segment_name(e->d_name, &segment) == 0) remove(e->d_name);
+    closedir(d);
+}
+
+static int scratch_leave(const char *cwd, const char *dir) {
+    scratch_clean();
+    if (chdir(cwd) != 0 || rmdir(dir) != 0) {
+        fprintf(stderr, "Unable to remove %s\n", dir);
+        return -1;
+    }
+    return 0;
+}
+
+/* Hammer the engine with random postings against a scratch data set and
+   check that no update was lost: the final total must equal the starting
+   total plus every accepted deposit minus every accepted withdrawal, both
+   in memory and after reloading from disk. */
+/* Scans snapshots while the stress postings run. Each scan must add up to
+   the live total at the moment its snapshot opened. */
+typedef struct {
+    int stop;
+    long scans, mismatches;
+} SnapCheck;
+
+static void *stress_snapshot_main(void *arg) {
+    SnapCheck *sc = arg;
+    long balance[SNAP_PAGE];
+    struct timespec pause = { 0, 20000 };
+    do {
+        Snapshot snap;
+        long live = 0, seen = 0;
+        pthread_mutex_lock(&store_balance_lock);
+        for (int k = 0; k < store.cust.count; ++k) live += store.cust.hot[k].balance;
+        snap_begin(&store.snaps, &snap, store.cust.count);
+        pthread_mutex_unlock(&store_balance_lock);
+        for (int first = 0; first < snap.count; first += SNAP_PAGE) {
+            int n = snap.count - first < SNAP_PAGE ? snap.count - first : SNAP_PAGE;
+            store_snapshot_balances(&snap, first, n, balance);
+            for (int k = 0; k < n; ++k) seen += balance[k];
+            nanosleep(&pause, NULL);    /* let postings land mid-scan */
+        }
+        if (store_snapshot_end(&snap) != 0 || seen != live) sc->mismatches++;
+        sc->scans++;
+    } while (!__atomic_load_n(&sc->stop, __ATOMIC_ACQUIRE));
+    return NULL;
+}
+
+static int run_stress(int threads, long ntx, int accounts) {
+    char cwd[4096], dir[] = "/tmp/banking-stress-XXXXXX";
+    if (scratch_enter(cwd, sizeof(cwd), dir) != 0) return 1;
+    CustTable seed = {0};
+    Transaction *txs = malloc(ntx * sizeof(Transaction));
+    int rc = 1;
+    if (!txs) goto out;
+    long start_total = 0;
+    for (int k = 0; k < accounts; ++k) {
+        Customer c;
+        c.account = k + 1;
+        snprintf(c.name, sizeof(c.name), "Stress Customer");
+        snprintf(c.aadhaar, sizeof(c.aadhaar), "%012d", k + 1);
+        snprintf(c.phone, sizeof(c.phone), "%010d", k + 1);
+        c.balance = 10000;
+        snprintf(c.address, sizeof(c.address), "Scratch");
+        if (ct_append(&seed, &c) != 0) goto out;
+        start_total += c.balance;
+    }
+    if (save_customers(&seed) != 0 || store_load() != 0) goto out;
+    uint32_t rng = 2463534242U;
+    for (long k = 0; k < ntx; ++k) {
+        rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+        txs[k].account = (int)(rng % (uint32_t)accounts) + 1;
+        txs[k].type = (rng >> 12) & 1 ? 'D' : 'W';
+        txs[k].amount = 500 + (long)((rng >> 13) % 10000);
+        txs[k].error = NULL;
+    }
+
+    TxEngine engine;
+    SnapCheck check = {0};
+    pthread_t checker;
+    if (tx_engine_start(&engine, threads, 0) != 0) goto out;
+    int checking = pthread_create(&checker, NULL, stress_snapshot_main, &check) == 0;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long k = 0; k < ntx; ++k) tx_submit(&engine, &txs[k]);
+    tx_engine_stop(&engine);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    __atomic_store_n(&check.stop, 1, __ATOMIC_RELEASE);
+    if (checking) pthread_join(checker, NULL);
+    long versions_left = snap_versions(&store.snaps);
+    double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    long batches = store.gc.batches, committed = store.gc.ops;
+
+    long expected = start_total, accepted = 0, below_min = 0;
+    for (long k = 0; k < ntx; ++k) {
+        if (txs[k].error) continue;
+        expected += txs[k].type == 'W' ? -txs[k].amount : txs[k].amount;
+        accepted++;
+    }
+    long total = 0;
+    for (int k = 0; k < store.cust.count; ++k) {
+        total += store.cust.hot[k].balance;
+        if (store.cust.hot[k].balance < MIN_BALANCE) below_min++;
+    }
+    /* The balance index must list every account once, in balance order */
+    int *order, indexed = store_find_balances(LONG_MIN, LONG_MAX, INT_MAX, &order);
+    int index_ok = indexed == store.cust.count;
+    for (int k = 0; index_ok && k < indexed; ++k)
+        index_ok = order[k] >= 0 &&
+                   (k == 0 || store.cust.hot[order[k]].balance <= store.cust.hot[order[k-1]].balance);
+    free(order);
+    store_free();
+    long reloaded = 0;
+    if (store_load() != 0) goto out;
+    for (int k = 0; k < store.cust.count; ++k) reloaded += store.cust.hot[k].balance;
+    store_free();
+
+    printf("threads=%d transactions=%ld accepted=%ld seconds=%.3f tx_per_sec=%.0f\n",
+           threads, ntx, accepted, secs, secs > 0 ? ntx / secs : 0.0);
+    printf("commit_batches=%ld ops_per_batch=%.1f\n", batches, batches ? (double)committed / batches : 0.0);
+    printf("expected_total=%ld memory_total=%ld reloaded_total=%ld below_min_balance=%ld balance_index=%s\n",
+           expected, total, reloaded, below_min, index_ok ? "ok" : "broken");
+    printf("snapshot_scans=%ld snapshot_mismatches=%ld snapshot_versions_left=%ld\n",
+           check.scans, check.mismatches, versions_left);
+    rc = (total == expected && reloaded == expected && below_min == 0 && index_ok &&
+          checking && check.mismatches == 0 && versions_left == 0) ? 0 : 1;
+    printf("%s\n", rc == 0 ? "PASS: balance conserved" : "FAIL: balance not conserved");
+out:
+    ct_free(&seed);
+    free(txs);
+    scratch_leave(cwd, dir);
+    return rc;
+}
+
+static double elapsed_since(const struct timespec *t0) {
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0->tv_sec) + (t1.tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+/* Microbenchmark: parse a customers file with the original per-line loop
+   and with the vectorized scanner path (both single-threaded), time each
+   delimiter scanner on its own, and check that both parsers agree. Output
+   is one key=value line per measurement. */
+static int run_bench_parse(const char *path) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+        fprintf(stderr, "Unable to read %s\n", path);
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+    size_t size = (size_t)st.st_size;
+    const char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return 1;
+    double mb = size / 1e6;
+    const int rounds = 3;
+
+    /* Baseline: the loop load_customers used to run */
+    Customer *ref = NULL;
+    int nref = 0;
+    double best = 1e30;
+    for (int r = 0; r < rounds; ++r) {
+        struct timespec t0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        size_t cap = 1024;
+        Customer *arr = malloc(cap * sizeof(Customer));
+        int n = 0;
+        char line[MAX_LINE];
+        for (const char *p = data, *end = data + size; arr && p < end;) {
+            const char *nl = memchr(p, '\n', end - p);
+            const char *eol = nl ? nl : end;
+            size_t len = (size_t)(eol - p) < sizeof(line) - 1 ? (size_t)(eol - p) : sizeof(line) - 1;
+            memcpy(line, p, len);
+            line[len] = '\0';
+            trim_newline(line);
+            if ((size_t)n == cap) {
+                Customer *grown = realloc(arr, cap * 2 * sizeof(Customer));
+                if (!grown) { free(arr); arr = NULL; break; }
+                arr = grown;
+                cap *= 2;
             }
-            if (removed == 0) printf("\n\tNo matching records found.\n");
-            save_employees(newarr, newc);
-            printf("\n\tDeleted %d records.\n", removed);
-            free(newarr);
+            if (line[0] != '\0' && parse_customer_line(line, &arr[n]) == 0) n++;
+            p = eol + 1;
         }
-        free(emps);
-    } else if (ch == 2) {
-        Customer *custs = NULL; int count = 0;
-        load_customers(&custs, &count);
-        if (count == 0) { printf("\n\tData file was empty\n"); free(custs); return; }
-        printf("\n\t1. By Account\n\t2. By Name\n\t3. By aadhaar\n\t4. Delete all\n");
-        read_line_input("\n\tEnter option: ", buf, sizeof(buf));
-        int opt = atoi(buf);
-        
-        if (opt == 4) {
-            read_line_input("\n\tAre you sure to delete all? (YES/NO): ", buf, sizeof(buf));
-            if (strcasecmp(buf, "YES") == 0) { save_customers(NULL, 0); printf("\n\tAll deleted.\n"); }
-            else printf("\n\tCancelled.\n");
-        } else {
-            Customer *newarr = malloc(count * sizeof(Customer));
-            int newc = 0, removed = 0;
-            if (opt == 1) {
-                read_line_input("\n\tEnter account to delete: ", buf, sizeof(buf));
-                int acc = atoi(buf);
-                for (int i = 0; i < count; ++i) {
-                    if (custs[i].account == acc) { removed++; continue; }
-                    newarr[newc++] = custs[i];
-                }
-            } else if (opt == 2) {
-                read_line_input("\n\tEnter name to delete: ", buf, sizeof(buf));
-                for (int i = 0; i < count; ++i) {
-                    if (strcasecmp(custs[i].name, buf) == 0) { removed++; continue; }
-                    newarr[newc++] = custs[i];
-                }
-            } else if (opt == 3) {
-                read_line_input("\n\tEnter aadhaar to delete: ", buf, sizeof(buf));
-                for (int i = 0; i < count; ++i) {
-                    if (strcmp(custs[i].aadhaar, buf) == 0) { removed++; continue; }
-                    newarr[newc++] = custs[i];
-                }
-            } else {
-                printf("\n\tInvalid option\n");
-                free(newarr); free(custs);
-                return;
-            }
-            if (removed == 0) printf("\n\tNo matching records found.\n");
-            save_customers(newarr, newc);
-            printf("\n\tDeleted %d records.\n", removed);
-            free(newarr);
+        if (!arr) {
+            fprintf(stderr, "Out of memory parsing %s\n", path);
+            free(ref);
+            munmap((void *)data, size);
+            return 1;
         }
-        free(custs);
-    } else {
-        printf("\n\tInvalid choice\n");
+        double t = elapsed_since(&t0);
+        if (t < best) best = t;
+        free(ref);
+        ref = arr;
+        nref = n;
+    }
+    printf("parse_loop_mb_s=%.1f records=%d\n", mb / best, nref);
+
+    LoadChunk ch;
+    best = 1e30;
+    for (int r = 0; r < rounds; ++r) {
+        memset(&ch, 0, sizeof(ch));
+        ch.begin = data;
+        ch.end = data + size;
+        ch.nfields = 6;
+        ch.parse = parse_customer_fields;
+        ch.rec_size = sizeof(CustRow);
+        ch.use_arena = 1;
+        struct timespec t0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        load_chunk(&ch);
+        double t = elapsed_since(&t0);
+        if (t < best) best = t;
+        if (r < rounds - 1) {
+            free(ch.recs);
+            arena_free(&ch.arena);
+        }
+    }
+    printf("parse_vector_mb_s=%.1f records=%d\n", mb / best, ch.n);
+    printf("bytes_per_customer_inline=%zu bytes_per_customer_split=%.1f\n", sizeof(Customer),
+           ch.n ? sizeof(CustHot) + sizeof(CustCold) + (double)ch.arena.len / ch.n : 0.0);
+
+    int mismatches = ch.n == nref ? 0 : 1;
+    const CustRow *vec = (const CustRow *)ch.recs;
+    for (int k = 0; !mismatches && k < nref; ++k) {
+        const char *f[CF_COUNT];
+        for (int c = 0; c < CF_COUNT; ++c) f[c] = arena_str(&ch.arena, vec[k].cold.off[c]);
+        if (vec[k].hot.account != ref[k].account || vec[k].hot.balance != ref[k].balance ||
+            strcmp(f[CF_NAME], ref[k].name) != 0 || strcmp(f[CF_AADHAAR], ref[k].aadhaar) != 0 ||
+            strcmp(f[CF_PHONE], ref[k].phone) != 0 || strcmp(f[CF_ADDRESS], ref[k].address) != 0)
+            mismatches++;
+    }
+    free(ch.recs);
+    arena_free(&ch.arena);
+    free(ref);
+
+    struct { const char *name; DelimScanner fn; } scanners[3];
+    int nscan = 0;
+    scanners[nscan].name = "scalar"; scanners[nscan++].fn = scan_delims_scalar;
+#if defined(__x86_64__)
+    scanners[nscan].name = "sse2"; scanners[nscan++].fn = scan_delims_sse2;
+    if (__builtin_cpu_supports("avx2")) { scanners[nscan].name = "avx2"; scanners[nscan++].fn = scan_delims_avx2; }
+#endif
+    uint32_t *pos = malloc(SCAN_BLOCK * sizeof(uint32_t));
+    size_t expect = 0;
+    for (int s = 0; s < nscan && pos; ++s) {
+        size_t found = 0;
+        best = 1e30;
+        for (int r = 0; r < rounds; ++r) {
+            struct timespec t0;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            found = 0;
+            for (size_t off = 0; off < size; off += SCAN_BLOCK)
+                found += scanners[s].fn(data + off, size - off < SCAN_BLOCK ? size - off : SCAN_BLOCK, pos);
+            double t = elapsed_since(&t0);
+            if (t < best) best = t;
+        }
+        if (s == 0) expect = found;
+        else if (found != expect) mismatches++;
+        printf("scan_%s_mb_s=%.1f delimiters=%zu\n", scanners[s].name, mb / best, found);
     }
+    free(pos);
+    munmap((void *)data, size);
+    printf("results_match=%s\n", mismatches ? "no" : "yes");
+    return mismatches ? 1 : 0;
 }
 
-void update_data() {
-    printf("\n\t1. Employee\n\t2. Customer\n");
-    char buf[128];
-    read_line_input("\n\tEnter: ", buf, sizeof(buf));
-    int ch = atoi(buf);
-    if (ch == 1) {
-        Employee *emps = NULL; int count = 0;
-        load_employees(&emps, &count);
-        if (count == 0) {
-            printf("\n\tData file was empty\n");
-            free(emps);
-            return;
+/* Synthetic data for benchmarks and sizing: valid records in the format
+   of EMP_FILE and CUST_FILE. IDs and accounts run from 1. Aadhaar and
+   phone numbers are a fixed permutation of the record number, so they are
+   distinct and can be recomputed from an account (gen_aadhaar, gen_phone). */
+static const char *const gen_first[] = {
+    "Aarav", "Priya", "Rahul", "Sneha", "Vikram", "Anita", "Rohan", "Kavya", "Suresh", "Meera",
+    "Arjun", "Divya", "Karan", "Pooja", "Ravi", "Neha", "Amit", "Lakshmi", "Sanjay", "Fatima"
+};
+static const char *const gen_last[] = {
+    "Sharma", "Verma", "Patel", "Gupta", "Singh", "Kumar", "Reddy", "Nair", "Iyer", "Das",
+    "Khan", "Mehta", "Joshi", "Rao", "Bose", "Pillai", "Menon", "Chopra", "Yadav", "Mishra"
+};
+static const char *const gen_streets[] = {
+    "MG Road", "Station Road", "Park Street", "Lake View", "Church Street", "Temple Road"
+};
+static const char *const gen_cities[] = {
+    "Mumbai", "Delhi", "Bengaluru", "Chennai", "Kolkata", "Pune", "Hyderabad", "Jaipur"
+};
+static const char *const gen_designations[] = {
+    "Manager", "Clerk", "Cashier", "Teller", "Officer", "Analyst", "Auditor"
+};
+#define GEN_PICK(list, r) list[(r) % (sizeof(list) / sizeof(list[0]))]
+
+static uint32_t gen_next(uint32_t *rng) {
+    *rng ^= *rng << 13; *rng ^= *rng >> 17; *rng ^= *rng << 5;
+    return *rng;
+}
+
+static void gen_aadhaar(int account, char *out) {
+    snprintf(out, MAX_AAD, "%lld", 100000000000LL + (long long)account * 1000003 % 900000000000LL);
+}
+
+static void gen_phone(int account, char *out) {
+    snprintf(out, MAX_PHONE, "%lld", 6000000000LL + (long long)account * 1000003 % 4000000000LL);
+}
+
+static int generate_data(int nemp, int ncust, uint32_t seed) {
+    uint32_t rng = seed ? seed : 1;
+    FILE *f = fopen(EMP_FILE, "w");
+    if (!f) return -1;
+    for (int id = 1; id <= nemp; ++id) {
+        uint32_t r = gen_next(&rng);
+        fprintf(f, "%d|%s %s|%u|%s\n", id, GEN_PICK(gen_first, r), GEN_PICK(gen_last, r >> 8),
+                15000 + (r >> 12) % 185000, GEN_PICK(gen_designations, r >> 5));
+    }
+    if (fclose(f) != 0) return -1;
+    if (!(f = fopen(CUST_FILE, "w"))) return -1;
+    for (int acc = 1; acc <= ncust; ++acc) {
+        uint32_t r = gen_next(&rng), r2 = gen_next(&rng);
+        char aadhaar[MAX_AAD], phone[MAX_PHONE];
+        gen_aadhaar(acc, aadhaar);
+        gen_phone(acc, phone);
+        fprintf(f, "%d|%s %s|%s|%s|%u|%u %s, %s\n", acc, GEN_PICK(gen_first, r), GEN_PICK(gen_last, r >> 8),
+                aadhaar, phone, MIN_BALANCE + r2 % 1000000, 1 + (r >> 16) % 999,
+                GEN_PICK(gen_streets, r2 >> 20), GEN_PICK(gen_cities, r2 >> 24));
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static int run_generate(int ncust, int nemp, uint32_t seed) {
+    const char *existing[] = { EMP_FILE, CUST_FILE, CUST_MANIFEST, EMP_BIN, CUST_BIN, CUST_JOURNAL, EMP_TOMBSTONES };
+    for (size_t k = 0; k < sizeof(existing) / sizeof(existing[0]); ++k) {
+        if (access(existing[k], F_OK) == 0) {
+            fprintf(stderr, "%s already exists; generate only writes into an empty directory\n", existing[k]);
+            return 1;
         }
-        read_line_input("\n\tEnter Employee ID to update: ", buf, sizeof(buf));
-        int id = atoi(buf);
-        
-        int found = 0;
-        for (int i = 0; i < count; ++i) {
-            if (emps[i].id == id) {
-                found = 1;
-                printf("\n\tFound:\n");
-                print_employees(&emps[i], 1);
-                read_line_input("\n\tUpdate: 1.Name 2.Salary 3.Designation 4.All: ", buf, sizeof(buf));
-                int opt = atoi(buf);
-                if (opt == 1) { 
-                    char temp[MAX_NAME];
-                    while (1) {
-                        read_line_input("\n\tNew name: ", temp, sizeof(temp));
-                        if (strlen(temp) == 0 || !is_alphabetic(temp)) {
-                            printf("\n\tInvalid name - must contain only letters and spaces\n");
-                            continue;
-                        }
-                        strcpy(emps[i].name, temp);
-                        break;
-                    }
-                }
-                else if (opt == 2) { 
-                    char temp[32];
-                    while (1) {
-                        read_line_input("\n\tNew salary: ", temp, sizeof(temp));
-                        if (strlen(temp) == 0 || !is_numeric(temp)) {
-                            printf("\n\tInvalid salary - must contain only digits\n");
-                            continue;
-                        }
-                        strcpy(emps[i].salary, temp);
-                        break;
-                    }
-                }
-                else if (opt == 3) { 
-                    char temp[MAX_DESIGN];
-                    while (1) {
-                        read_line_input("\n\tNew designation: ", temp, sizeof(temp));
-                        if (strlen(temp) == 0 || !is_alphabetic(temp)) {
-                            printf("\n\tInvalid designation - must contain only letters and spaces\n");
-                            continue;
-                        }
-                        strcpy(emps[i].designation, temp);
-                        break;
-                    }
-                }
-                else if (opt == 4) {
-                    char temp[MAX_NAME];
-                    /* Update name with validation */
-                    while (1) {
-                        read_line_input("\n\tNew name: ", temp, sizeof(temp));
-                        if (strlen(temp) == 0 || !is_alphabetic(temp)) {
-                            printf("\n\tInvalid name - must contain only letters and spaces\n");
-                            continue;
-                        }
-                        strcpy(emps[i].name, temp);
-                        break;
-                    }
-                    /* Update salary with validation */
-                    while (1) {
-                        read_line_input("\n\tNew salary: ", temp, sizeof(temp));
-                        if (strlen(temp) == 0 || !is_numeric(temp)) {
-                            printf("\n\tInvalid salary - must contain only digits\n");
-                            continue;
-                        }
-                        strcpy(emps[i].salary, temp);
-                        break;
-                    }
-                    /* Update designation with validation */
-                    while (1) {
-                        read_line_input("\n\tNew designation: ", temp, sizeof(temp));
-                        if (strlen(temp) == 0 || !is_alphabetic(temp)) {
-                            printf("\n\tInvalid designation - must contain only letters and spaces\n");
-                            continue;
-                        }
-                        strcpy(emps[i].designation, temp);
-                        break;
-                    }
-                } else { printf("\n\tInvalid option\n"); }
-                break;
-            }
+    }
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (generate_data(nemp, ncust, seed) != 0) {
+        fprintf(stderr, "Unable to write data files\n");
+        return 1;
+    }
+    printf("employees=%d customers=%d seed=%u seconds=%.3f\n", nemp, ncust, seed, elapsed_since(&t0));
+    return 0;
+}
+
+/* Benchmark suite: for each size, generate a data set in a scratch
+   directory and time every store operation the menu uses against it.
+   One key=value line per measurement:
+     rows=N op=NAME ops=N seconds=S us_per_op=U results=R
+   where results counts the records found or written. */
+#define BENCH_LOOKUPS 10000
+#define BENCH_QUERIES 100
+#define BENCH_POSTINGS 200
+#define BENCH_DELETES 10
+
+static void bench_report(int rows, const char *op, int ops, double secs, long results) {
+    printf("rows=%d op=%s ops=%d seconds=%.6f us_per_op=%.2f results=%ld\n",
+           rows, op, ops, secs, ops ? secs * 1e6 / ops : 0.0, results);
+    fflush(stdout);
+}
+
+static int bench_size(int rows, uint32_t seed) {
+    int nemp = rows / 10 ? rows / 10 : 1;
+    uint32_t rng = seed;
+    struct timespec t0;
+    long results;
+    char key[MAX_NAME];
+    int *pos, n;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (generate_data(nemp, rows, seed) != 0) return -1;
+    bench_report(rows, "generate", 1, elapsed_since(&t0), rows + nemp);
+
+    CustTable t = {0};
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (load_customers(&t) != 0) return -1;
+    bench_report(rows, "load_customers", 1, elapsed_since(&t0), t.count);
+    ct_free(&t);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (store_load() != 0) return -1;
+    bench_report(rows, "store_load", 1, elapsed_since(&t0), store.cust.count + store.emp_count);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (save_customers(&store.cust) != 0) goto fail;
+    bench_report(rows, "save_customers", 1, elapsed_since(&t0), store.cust.count);
+
+    results = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int q = 0; q < BENCH_LOOKUPS; ++q)
+        results += store_find_customer(1 + gen_next(&rng) % rows) >= 0;
+    bench_report(rows, "search_account", BENCH_LOOKUPS, elapsed_since(&t0), results);
+
+    results = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int q = 0; q < BENCH_LOOKUPS; ++q) {
+        gen_aadhaar(1 + gen_next(&rng) % rows, key);
+        results += store_find_aadhaar(key) >= 0;
+    }
+    bench_report(rows, "search_aadhaar", BENCH_LOOKUPS, elapsed_since(&t0), results);
+
+    results = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int q = 0; q < BENCH_LOOKUPS; ++q) {
+        gen_phone(1 + gen_next(&rng) % rows, key);
+        results += store_find_phone(key) >= 0;
+    }
+    bench_report(rows, "search_phone", BENCH_LOOKUPS, elapsed_since(&t0), results);
+
+    results = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int q = 0; q < BENCH_QUERIES; ++q) {
+        long lo = MIN_BALANCE + gen_next(&rng) % 1000000;
+        if ((n = store_find_balances(lo, lo + 1000, INT_MAX, &pos)) < 0) goto fail;
+        results += n;
+        free(pos);
+    }
+    bench_report(rows, "search_balance_range", BENCH_QUERIES, elapsed_since(&t0), results);
+
+    results = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int q = 0; q < BENCH_QUERIES; ++q) {
+        if ((n = store_find_balances(LONG_MIN, LONG_MAX, 10, &pos)) < 0) goto fail;
+        results += n;
+        free(pos);
+    }
+    bench_report(rows, "search_top_balances", BENCH_QUERIES, elapsed_since(&t0), results);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (store_build_names() != 0) goto fail;
+    bench_report(rows, "name_index_build", 1, elapsed_since(&t0), store.cust.count + store.emp_count);
+
+    results = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int q = 0; q < BENCH_QUERIES; ++q) {
+        uint32_t r = gen_next(&rng);
+        snprintf(key, sizeof(key), "%s %.3s", GEN_PICK(gen_first, r), GEN_PICK(gen_last, r >> 8));
+        if ((n = store_find_name_prefix(0, key, &pos)) < 0) goto fail;
+        results += n;
+        free(pos);
+    }
+    bench_report(rows, "search_name_prefix", BENCH_QUERIES, elapsed_since(&t0), results);
+
+    results = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int q = 0; q < BENCH_QUERIES; ++q) {
+        uint32_t r = gen_next(&rng);
+        int len = snprintf(key, sizeof(key), "%s %s", GEN_PICK(gen_first, r), GEN_PICK(gen_last, r >> 8));
+        int at = 1 + (r >> 16) % (len - 2);     /* one transposed pair as the typo */
+        char c = key[at]; key[at] = key[at+1]; key[at+1] = c;
+        if ((n = store_find_name_similar(0, key, &pos)) < 0) goto fail;
+        results += n;
+        free(pos);
+    }
+    bench_report(rows, "search_name_fuzzy", BENCH_QUERIES, elapsed_since(&t0), results);
+
+    results = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int q = 0; q < BENCH_LOOKUPS; ++q)
+        results += store_find_employee(1 + gen_next(&rng) % nemp) >= 0;
+    bench_report(rows, "search_employee_id", BENCH_LOOKUPS, elapsed_since(&t0), results);
+
+    results = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int q = 0; q < BENCH_QUERIES; ++q) {
+        if ((n = store_find_designation(GEN_PICK(gen_designations, gen_next(&rng)), &pos)) < 0) goto fail;
+        results += n;
+        free(pos);
+    }
+    bench_report(rows, "search_designation", BENCH_QUERIES, elapsed_since(&t0), results);
+
+    results = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int q = 0; q < BENCH_QUERIES; ++q) {
+        long lo = 15000 + gen_next(&rng) % 185000;
+        if ((n = store_find_salaries(lo, lo + 100, &pos)) < 0) goto fail;
+        results += n;
+        free(pos);
+    }
+    bench_report(rows, "search_salary_range", BENCH_QUERIES, elapsed_since(&t0), results);
+
+    /* Durable postings, one at a time as from the menu */
+    for (int type = 0; type < 2; ++type) {
+        results = 0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (int q = 0; q < BENCH_POSTINGS; ++q) {
+            Transaction tx = { .account = 1 + gen_next(&rng) % rows, .type = type ? 'W' : 'D', .amount = MIN_DEPOSIT };
+            results += tx_execute(&tx, 0) == 0;
         }
-        if (!found) printf("\n\tEmployee not found\n");
-        save_employees(emps, count);
-        free(emps);
-    } else if (ch == 2) {
-        Customer *custs = NULL; int count = 0;
-        load_customers(&custs, &count);
-        if (count == 0) {
-            printf("\n\tData file was empty\n");
-            free(custs);
-            return;
+        bench_report(rows, type ? "withdraw" : "deposit", BENCH_POSTINGS, elapsed_since(&t0), results);
+    }
+
+    results = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int q = 0; q < BENCH_DELETES; ++q) {
+        int i = store_find_customer(1 + gen_next(&rng) % rows);
+        if (i < 0) continue;
+        if (store_remove_customers(&i, 1) != 0 || store_flush() != 0) goto fail;
+        results++;
+    }
+    bench_report(rows, "delete_customer", BENCH_DELETES, elapsed_since(&t0), results);
+
+    for (int employees = 0; employees <= 1; ++employees) {
+        for (int format = EXPORT_TEXT; format <= EXPORT_FIXED; ++format) {
+            char op[64];
+            ExportSpec spec;
+            if (export_spec(&spec, employees, export_formats[format], NULL) != 0) goto fail;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            long n = export_table(&spec, "bench-export.txt");
+            if (n < 0) goto fail;
+            snprintf(op, sizeof(op), "export_%s_%s", employees ? "employees" : "customers", export_formats[format]);
+            bench_report(rows, op, 1, elapsed_since(&t0), n);
         }
-        read_line_input("\n\tEnter Customer Account to update: ", buf, sizeof(buf));
-        int acc = atoi(buf);
-        
-        int found = 0;
-        for (int i = 0; i < count; ++i) {
-            if (custs[i].account == acc) {
-                found = 1;
-                printf("\n\tFound:\n");
-                print_customers(&custs[i], 1);
-                read_line_input("\n\tUpdate: 1.Name 2.aadhaar 3.Phone 4.Address 5.Balance 6.All: ", buf, sizeof(buf));
-                int opt = atoi(buf);
-                if (opt == 1) {
-                    char temp[MAX_NAME];
-                    while (1) {
-                        read_line_input("\n\tNew name: ", temp, sizeof(temp));
-                        if (strlen(temp) == 0 || !is_alphabetic(temp)) {
-                            printf("\n\tInvalid name - must contain only letters and spaces\n");
-                            continue;
-                        }
-                        strcpy(custs[i].name, temp);
-                        break;
-                    }
-                }
-                else if (opt == 2) {
-                    char temp[MAX_AAD];
-                    while (1) {
-                        read_line_input("\n\tNew aadhaar: ", temp, sizeof(temp));
-                        if (strlen(temp) != 12 || !is_numeric(temp)) {
-                            printf("\n\tInvalid aadhaar - must be exactly 12 digits\n");
-                            continue;
-                        }
-                        strcpy(custs[i].aadhaar, temp);
-                        break;
-                    }
-                }
-                else if (opt == 3) {
-                    char temp[MAX_PHONE];
-                    while (1) {
-                        read_line_input("\n\tNew phone: ", temp, sizeof(temp));
-                        if (strlen(temp) != 10 || !is_numeric(temp)) {
-                            printf("\n\tInvalid phone - must be exactly 10 digits\n");
-                            continue;
-                        }
-                        strcpy(custs[i].phone, temp);
-                        break;
-                    }
-                }
-                else if (opt == 4) {
-                    char temp[MAX_ADDR];
-                    while (1) {
-                        read_line_input("\n\tNew address: ", temp, sizeof(temp));
-                        if (strlen(temp) == 0) {
-                            printf("\n\tAddress cannot be empty\n");
-                            continue;
-                        }
-                        strcpy(custs[i].address, temp);
-                        break;
-                    }
-                }
-                else if (opt == 5) {
-                    char temp[64];
-                    while (1) {
-                        read_line_input("\n\tNew balance: ", temp, sizeof(temp));
-                        if (!is_numeric(temp)) {
-                            printf("\n\tInvalid balance - must contain only digits\n");
-                            continue;
-                        }
-                        custs[i].balance = atol(temp);
-                        break;
-                    }
-                } else if (opt == 6) {
-                    char temp[MAX_ADDR];
-                    /* Update name with validation */
-                    while (1) {
-                        read_line_input("\n\tNew name: ", temp, sizeof(temp));
-                        if (strlen(temp) == 0 || !is_alphabetic(temp)) {
-                            printf("\n\tInvalid name - must contain only letters and spaces\n");
-                            continue;
-                        }
-                        strcpy(custs[i].name, temp);
-                        break;
-                    }
-                    /* Update aadhaar with validation */
-                    while (1) {
-                        read_line_input("\n\tNew aadhaar: ", temp, sizeof(temp));
-                        if (strlen(temp) != 12 || !is_numeric(temp)) {
-                            printf("\n\tInvalid aadhaar - must be exactly 12 digits\n");
-                            continue;
-                        }
-                        strcpy(custs[i].aadhaar, temp);
-                        break;
-                    }
-                    /* Update phone with validation */
-                    while (1) {
-                        read_line_input("\n\tNew phone: ", temp, sizeof(temp));
-                        if (strlen(temp) != 10 || !is_numeric(temp)) {
-                            printf("\n\tInvalid phone - must be exactly 10 digits\n");
-                            continue;
-                        }
-                        strcpy(custs[i].phone, temp);
-                        break;
-                    }
-                    /* Update address with validation */
-                    while (1) {
-                        read_line_input("\n\tNew address: ", temp, sizeof(temp));
-                        if (strlen(temp) == 0) {
-                            printf("\n\tAddress cannot be empty\n");
-                            continue;
-                        }
-                        strcpy(custs[i].address, temp);
-                        break;
-                    }
-                } else {
-                    printf("\n\tInvalid option\n");
-                }
-                break;
-            }
+    }
+
+    store_free();
+    remove("bench-export.txt");
+    return 0;
+fail:
+    store_free();
+    remove("bench-export.txt");
+    return -1;
+}
+
+static int run_bench(const int *sizes, int nsizes, uint32_t seed) {
+    char cwd[4096], dir[] = "/tmp/banking-bench-XXXXXX";
+    if (scratch_enter(cwd, sizeof(cwd), dir) != 0) return 1;
+    int rc = 0;
+    for (int k = 0; k < nsizes && rc == 0; ++k) {
+        if (bench_size(sizes[k], seed) != 0) {
+            fprintf(stderr, "Benchmark failed at rows=%d\n", sizes[k]);
+            rc = 1;
         }
-        if (!found) printf("\n\tCustomer not found\n");
-        save_customers(custs, count);
-        free(custs);
+        scratch_clean();
+    }
+    return scratch_leave(cwd, dir) == 0 ? rc : 1;
+}
+
+/* Load generator for `serve`: CLIENTS connections, each sending one request
+   at a time (a teller waiting on its answer) until REQUESTS have been sent
+   in total. Requests look up random accounts, and WRITE_PERCENT of them
+   deposit or withdraw MIN_DEPOSIT instead. Prints one key=value line:
+     clients=N requests=N write_percent=N seconds=S requests_per_sec=R
+     ok=N err=N p50_us=.. p99_us=.. max_us=..
+   err counts ERR replies (a denied withdrawal is one); a broken connection
+   fails the run. */
+typedef struct {
+    const char *target;
+    int requests, write_percent, accounts;
+    uint32_t seed;
+    long ok, err;
+    uint64_t max_ns;
+    uint64_t buckets[METRIC_BUCKETS];
+    int failed;
+} LoadClient;
+
+/* target is a socket path, or a port number on 127.0.0.1 */
+static int loadgen_connect(const char *target) {
+    int fd;
+    if (is_numeric(target)) {
+        struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(atoi(target)) };
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) return fd;
     } else {
-        printf("\n\tInvalid choice\n");
+        struct sockaddr_un addr = { .sun_family = AF_UNIX };
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", target);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) return fd;
     }
+    if (fd >= 0) close(fd);
+    return -1;
 }
 
-void create_export() {
-    printf("\n\t1. Create TXT for Employees\n\t2. Create TXT for Customers\n");
-    char buf[128];
-    read_line_input("\n\tEnter: ", buf, sizeof(buf));
-    int ch = atoi(buf);
-    
-    if (ch == 1) {
-        Employee *emps = NULL; int count = 0;
-        load_employees(&emps, &count);
-        if (count == 0) {
-            printf("\n\tData file was empty\n");
-            free(emps);
-            return;
+/* Send one request line and read its one-line reply into reply */
+static int loadgen_call(int fd, const char *request, char *reply, size_t size) {
+    size_t len = strlen(request), got = 0;
+    while (len > 0) {
+        ssize_t n = send(fd, request, len, MSG_NOSIGNAL);
+        if (n <= 0) return -1;
+        request += n;
+        len -= n;
+    }
+    for (;;) {
+        ssize_t n = recv(fd, reply + got, size - 1 - got, 0);
+        if (n <= 0) return -1;
+        got += n;
+        if (reply[got - 1] == '\n') break;
+        if (got == size - 1) return -1;
+    }
+    reply[got - 1] = '\0';
+    return 0;
+}
+
+static void *loadgen_main(void *arg) {
+    LoadClient *lc = arg;
+    int fd = loadgen_connect(lc->target);
+    if (fd < 0) { lc->failed = 1; return NULL; }
+    uint32_t rng = lc->seed;
+    char request[64], reply[MAX_LINE];
+    for (int k = 0; k < lc->requests; ++k) {
+        uint32_t r = gen_next(&rng);
+        int account = 1 + gen_next(&rng) % lc->accounts;
+        if ((int)(r % 100) < lc->write_percent)
+            snprintf(request, sizeof(request), "%c|%d|%d\n", r & 128 ? 'W' : 'D', account, MIN_DEPOSIT);
+        else
+            snprintf(request, sizeof(request), "G|%d\n", account);
+        uint64_t t0 = metric_now();
+        if (loadgen_call(fd, request, reply, sizeof(reply)) != 0) { lc->failed = 1; break; }
+        uint64_t ns = metric_now() - t0;
+        lc->buckets[metric_bucket(ns)]++;
+        if (ns > lc->max_ns) lc->max_ns = ns;
+        if (strncmp(reply, "OK", 2) == 0) lc->ok++;
+        else lc->err++;
+    }
+    close(fd);
+    return NULL;
+}
+
+static int run_loadgen(const char *target, int clients, int requests, int write_percent) {
+    char reply[MAX_LINE];
+    int fd = loadgen_connect(target);
+    if (fd < 0 || loadgen_call(fd, "I\n", reply, sizeof(reply)) != 0 || strncmp(reply, "OK|", 3) != 0) {
+        fprintf(stderr, "No server answering on %s\n", target);
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+    close(fd);
+    /* reply is OK|customers|next_account; accounts are numbered from 1 */
+    const char *next = strrchr(reply, '|') + 1;
+    int accounts = atoi(next) - 1;
+    if (accounts < 1) {
+        fprintf(stderr, "Server holds no customers\n");
+        return 1;
+    }
+    LoadClient *lcs = calloc(clients, sizeof(LoadClient));
+    pthread_t *threads = calloc(clients, sizeof(pthread_t));
+    if (!lcs || !threads) { free(lcs); free(threads); return 1; }
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int started = 0;
+    for (; started < clients; ++started) {
+        LoadClient *lc = &lcs[started];
+        lc->target = target;
+        lc->requests = requests / clients + (started < requests % clients);
+        lc->write_percent = write_percent;
+        lc->accounts = accounts;
+        lc->seed = 2463534242U + 7919U * started;
+        if (pthread_create(&threads[started], NULL, loadgen_main, lc) != 0) break;
+    }
+    LoadClient total = { .failed = started < clients };
+    for (int k = 0; k < started; ++k) {
+        pthread_join(threads[k], NULL);
+        total.ok += lcs[k].ok;
+        total.err += lcs[k].err;
+        total.failed |= lcs[k].failed;
+        if (lcs[k].max_ns > total.max_ns) total.max_ns = lcs[k].max_ns;
+        for (int b = 0; b < METRIC_BUCKETS; ++b) total.buckets[b] += lcs[k].buckets[b];
+    }
+    double secs = elapsed_since(&t0);
+    uint64_t count = total.ok + total.err;
+    uint64_t p50 = metric_quantile(total.buckets, count, 0.50), p99 = metric_quantile(total.buckets, count, 0.99);
+    printf("clients=%d requests=%llu write_percent=%d seconds=%.3f requests_per_sec=%.0f ok=%ld err=%ld "
+           "p50_us=%.1f p99_us=%.1f max_us=%.1f\n", clients, (unsigned long long)count, write_percent, secs,
+           secs > 0 ? count / secs : 0.0, total.ok, total.err, (p50 < total.max_ns ? p50 : total.max_ns) / 1e3,
+           (p99 < total.max_ns ? p99 : total.max_ns) / 1e3, total.max_ns / 1e3);
+    free(lcs);
+    free(threads);
+    if (total.failed) fprintf(stderr, "Connection to %s lost\n", target);
+    return total.failed ? 1 : 0;
+}
+
+/* Bulk-load CSV rows into a table; rejected rows go to REJECTS
+   (default FILE.rejects) as LINE|ROW|REJECTED|REASON */
+static int run_import(int employees, const char *in_path, const char *rejects_path) {
+    char default_rejects[4096];
+    if (!rejects_path) {
+        snprintf(default_rejects, sizeof(default_rejects), "%s.rejects", in_path);
+        rejects_path = default_rejects;
+    }
+    FILE *in = fopen(in_path, "r");
+    if (!in) { fprintf(stderr, "Unable to open %s\n", in_path); return 1; }
+    FILE *rej = fopen(rejects_path, "w");
+    if (!rej) { fprintf(stderr, "Unable to create %s\n", rejects_path); fclose(in); return 1; }
+    setvbuf(in, NULL, _IOFBF, 1 << 20);
+    if (store_load() != 0) {
+        fprintf(stderr, "Unable to load data files\n");
+        fclose(in);
+        fclose(rej);
+        return 1;
+    }
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    long imported, rejected;
+    int rc = import_csv(employees, in, rej, &imported, &rejected) == 0 ? 0 : 1;
+    double secs = elapsed_since(&t0);
+    fclose(in);
+    if (fclose(rej) != 0) rc = 1;
+    store_free();
+    if (rc) imported = 0;
+    fprintf(stderr, "Imported %ld, rejected %ld in %.3f s%s\n", imported, rejected, secs,
+            rc ? " (failed, nothing imported)" : "");
+    if (rejected) fprintf(stderr, "Rejected rows are listed in %s\n", rejects_path);
+    return rc;
+}
+
+/* Export a table without the menu and report the throughput:
+     rows=N bytes=N seconds=S mb_per_sec=R */
+static int run_export(int employees, const char *format, const char *path, const char *columns) {
+    ExportSpec spec;
+    if (export_spec(&spec, employees, format, columns) != 0) {
+        fprintf(stderr, "Unknown format or column\n");
+        return 2;
+    }
+    if (store_load() != 0) {
+        fprintf(stderr, "Unable to load data files\n");
+        return 1;
+    }
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    long rows = export_table(&spec, path);
+    double secs = elapsed_since(&t0);
+    store_free();
+    if (rows < 0) {
+        fprintf(stderr, "Unable to create %s\n", path);
+        return 1;
+    }
+    uint64_t bytes = file_bytes(path);
+    printf("rows=%ld bytes=%llu seconds=%.3f mb_per_sec=%.1f\n", rows, (unsigned long long)bytes, secs,
+           secs > 0 ? bytes / secs / 1e6 : 0.0);
+    return 0;
+}
+
+/* Count and sum the values of an integer column within [lo, hi] from a
+   columnar snapshot, reading only that column and skipping row groups
+   whose min/max rule them out:
+     rows=N matched=N sum=S groups=N groups_read=N bytes_read=N seconds=S */
+static int run_colscan(int employees, const char *column, long long lo, long long hi) {
+    const ColDef *defs = employees ? col_emp_defs : col_cust_defs;
+    int ncols = employees ? 4 : 6, col = -1;
+    for (int c = 0; c < ncols; ++c)
+        if (strcmp(defs[c].name, column) == 0 && (defs[c].encoding == COL_DELTA || defs[c].encoding == COL_PACKED))
+            col = c;
+    if (col < 0) {
+        fprintf(stderr, "Not an integer column: %s\n", column);
+        return 2;
+    }
+    const char *path = employees ? EMP_COL : CUST_COL;
+    ColFile cf;
+    if (col_open(&cf, path, employees) != 0) {
+        fprintf(stderr, "Unable to read %s\n", path);
+        return 1;
+    }
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int64_t *vals = malloc(COL_GROUP_ROWS * sizeof(int64_t));
+    long long matched = 0, sum = 0;
+    int read = 0, rc = vals ? 0 : 1;
+    for (uint32_t g = 0; rc == 0 && g < cf.ngroups; ++g) {
+        const ColChunk *c = col_chunk(&cf, g, col);
+        if (c->encoding != COL_LZ && (c->max < lo || c->min > hi)) continue;
+        if (col_ints(&cf, g, col, vals) != 0) {
+            fprintf(stderr, "Corrupt column chunk in %s\n", path);
+            rc = 1;
+            break;
         }
-        read_line_input("\n\tEnter file name (without ext): ", buf, sizeof(buf));
-        if (strlen(buf) == 0) { printf("\n\tInvalid file name\n"); return; }
-        char path[512];
-        snprintf(path, sizeof(path), "%s.txt", buf);
-        FILE *f = fopen(path, "w");
-        if (!f) { printf("\n\tUnable to create file\n"); free(emps); return; }
-        for (int i = 0; i < count; ++i) {
-            fprintf(f, "EMPLOYEE ID : %d  EMPLOYEE NAME : %s  EMPLOYEE DESIGNATION : %s\n",
-                    emps[i].id, emps[i].name, emps[i].designation);
-        }
-        fclose(f);
-        free(emps);
-        printf("\n\tCreated employee file at %s\n", path);
-    } else if (ch == 2) {
-        Customer *custs = NULL; int count = 0;
-        load_customers(&custs, &count);
-        if (count == 0) {
-            printf("\n\tData file was empty\n");
-            free(custs);
-            return;
+        read++;
+        for (uint32_t i = 0; i < cf.group_rows[g]; ++i) {
+            if (vals[i] < lo || vals[i] > hi) continue;
+            matched++;
+            sum += vals[i];
         }
-        read_line_input("\n\tEnter file name (without ext): ", buf, sizeof(buf));
-        if (strlen(buf) == 0) { printf("\n\tInvalid file name\n"); return; }
-        char path[512];
-        snprintf(path, sizeof(path), "%s.txt", buf);
-        FILE *f = fopen(path, "w");
-        if (!f) { printf("\n\tUnable to create file\n"); free(custs); return; }
-        for (int i = 0; i < count; ++i) {
-            fprintf(f, "ACCOUNT NUMBER : %d  CUSTOMER NAME : %s  BANK ACCOUNT BALANCE : %ld\n",
-                    custs[i].account, custs[i].name, custs[i].balance);
-        }
-        fclose(f);
-        free(custs);
-        printf("\n\tCreated customer file at %s\n", path);
-    } else {
-        printf("\n\tInvalid choice\n");
     }
+    if (rc == 0)
+        printf("rows=%llu matched=%lld sum=%lld groups=%u groups_read=%d bytes_read=%llu seconds=%.6f\n",
+               (unsigned long long)cf.rows, matched, sum, cf.ngroups, read, (unsigned long long)cf.bytes_read,
+               elapsed_since(&t0));
+    free(vals);
+    col_close(&cf);
+    return rc;
 }
 
-void withdraw_amount() {
-    char buf[64];
-    read_line_input("\n\tEnter account number: ", buf, sizeof(buf));
-    int acc = atoi(buf);
-    Customer *custs = NULL; int count = 0;
-    load_customers(&custs, &count);
-    if (count == 0) {
-        printf("\n\tData file was empty\n");
-        free(custs);
-        return;
+/* Re-cut the customer files (store_reshard) and list the new layout:
+     shard=K first_account=A file=F rows=R   per shard, then
+     shards=N customers=N seconds=S */
+static int run_shard(int shards, int max_rows) {
+    if (access(CUST_BIN, F_OK) == 0) {
+        fprintf(stderr, "Sharding applies to the text files; %s is in use\n", CUST_BIN);
+        return 1;
     }
-    int found = 0;
-    for (int i = 0; i < count; ++i) {
-        if (custs[i].account == acc) {
-            found = 1;
-            printf("\n\tAccount: %d  Name: %s\n", custs[i].account, custs[i].name);
-            printf("\n\tAvailable balance: %ld\n", custs[i].balance);
-            if (custs[i].balance <= 1000) { printf("\n\tNo available balance to withdraw (min balance 1000 required)\n"); break; }
-            
-            read_line_input("\n\tEnter amount to withdraw: ", buf, sizeof(buf));
-            if (!is_numeric(buf)) {
-                printf("\n\tInvalid amount.\n");
-                break;
-            }
-            long amount = atol(buf);
-            if (amount <= 0) {
-                printf("\n\tInvalid amount.\n");
-                break;
+    if (store_load() != 0) {
+        fprintf(stderr, "Unable to load data files\n");
+        return 1;
+    }
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    int rc = store_reshard(shards, max_rows);
+    double secs = elapsed_since(&t0);
+    if (rc < 0) {
+        fprintf(stderr, "Unable to rewrite the customer files\n");
+        store_free();
+        return 1;
+    }
+    int rows[SHARD_MAX] = { 0 };
+    for (int i = 0; i < store.cust.count; ++i) rows[shard_of(&cust_shards, store.cust.hot[i].account)]++;
+    for (int k = 0; k < cust_shards.count; ++k) {
+        char path[SHARD_PATH];
+        shard_path(cust_shards.file[k], path, sizeof(path));
+        printf("shard=%d first_account=%d file=%s rows=%d\n", k, cust_shards.first[k], path, rows[k]);
+    }
+    printf("shards=%d customers=%d seconds=%.3f\n", cust_shards.count, store.cust.count, secs);
+    store_free();
+    return 0;
+}
+
+/* Print the CHANGE FEED from sequence number from on, then the number to
+   resume from as next_seq=N on stderr. With follow the feed is polled for
+   new lines every FEED_POLL_MS instead, like tail -f; a consumer resumes
+   after the last seq it processed. */
+#define FEED_POLL_MS 200
+
+static int run_changes(uint64_t from, int follow) {
+    struct timespec pause = { 0, FEED_POLL_MS * 1000000L };
+    uint64_t next = from ? from : 1, segment = 0;
+    char line[MAX_LINE * 2];
+    FILE *f = NULL;
+    for (;;) {
+        if (!f || feed_segment_of(next) != segment) {
+            char path[FEED_PATH];
+            if (f) fclose(f);
+            segment = feed_segment_of(next);
+            feed_path(segment, path, sizeof(path));
+            if (!(f = fopen(path, "r"))) {
+                if (!follow) break;
+                nanosleep(&pause, NULL);
+                continue;
             }
-            
-            long remaining = custs[i].balance - amount;
-            if (remaining < 1000) { 
-                printf("\n\tWithdrawal denied.\n"); 
-                break; 
+        }
+        long pos = ftell(f);
+        if (fgets(line, sizeof(line), f) && strchr(line, '\n')) {
+            uint64_t seq = strtoull(line, NULL, 10);
+            if (seq >= next) {
+                fputs(line, stdout);
+                next = seq + 1;
             }
-            
-            read_line_input("\n\tConfirm withdraw (YES/NO): ", buf, sizeof(buf));
-            if (strcasecmp(buf, "YES") == 0) {
-                custs[i].balance = remaining;
-                save_customers(custs, count);
-                printf("\n\tWithdrawn. Remaining balance: %ld\n", custs[i].balance);
-            } else {
-                printf("\n\tCancelled.\n");
+            continue;
+        }
+        /* At the end, or at a line still being written. Once the next
+           segment exists this one is complete; numbers lost in a crash
+           can leave it short, so go on from the next one's first line. */
+        char newer[FEED_PATH];
+        feed_path(segment + 1, newer, sizeof(newer));
+        if (access(newer, F_OK) == 0) {
+            clearerr(f);
+            fseek(f, pos, SEEK_SET);
+            if (fgets(line, sizeof(line), f) && strchr(line, '\n')) {
+                fseek(f, pos, SEEK_SET);    /* written meanwhile; read it above */
+                continue;
             }
-            break;
+            next = (segment + 1) * FEED_SEGMENT_RECORDS + 1;
+            continue;
         }
+        if (!follow) break;
+        fflush(stdout);
+        nanosleep(&pause, NULL);
+        clearerr(f);
+        fseek(f, pos, SEEK_SET);
     }
-    if (!found) printf("\n\tAccount not found\n");
-    free(custs);
+    if (f) fclose(f);
+    fflush(stdout);
+    fprintf(stderr, "next_seq=%llu\n", (unsigned long long)next);
+    return 0;
 }
 
-void deposit_amount() {
-    char buf[64];
-    read_line_input("\n\tEnter account number: ", buf, sizeof(buf));
-    int acc = atoi(buf);
-    Customer *custs = NULL; int count = 0;
-    load_customers(&custs, &count);
-    if (count == 0) {
-        printf("\n\tData file was empty\n");
-        free(custs);
-        return;
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s                  interactive menu\n"
+            "       %s convert to-bin   convert %s/%s to %s/%s\n"
+            "       %s convert to-text  convert the binary files back to text\n"
+            "       %s convert to-col   write columnar snapshots %s/%s\n"
+            "       %s convert from-col replace the text files with the columnar snapshots\n"
+            "       %s colscan employees|customers COLUMN MIN MAX\n"
+            "                          count and sum an integer column of a columnar snapshot\n"
+            "       %s batch FILE [REPORT]\n"
+            "                          apply D|account|amount and W|account|amount lines\n"
+            "       %s stress [THREADS] [TRANSACTIONS] [ACCOUNTS]\n"
+            "                          check balance conservation under concurrent postings\n"
+            "       %s bench-parse [FILE]\n"
+            "                          compare the line-loop and vectorized customer parsers\n"
+            "       %s generate CUSTOMERS [EMPLOYEES [SEED]]\n"
+            "                          write synthetic %s/%s (EMPLOYEES defaults to CUSTOMERS/10)\n"
+            "       %s bench [ROWS...]\n"
+            "                          time every store operation at each size (default 10000 100000 1000000)\n"
+            "       %s import employees|customers FILE [REJECTS]\n"
+            "                          add CSV rows (%s / %s)\n"
+            "       %s export employees|customers text|csv|jsonl|fixed FILE [COLUMN,...]\n"
+            "                          write a table out without the menu\n"
+            "       %s shard COUNT      split %s into COUNT account ranges (1 joins them)\n"
+            "       %s rebalance [MAX_ROWS]\n"
+            "                          split customer shards over MAX_ROWS rows (default %d)\n"
+            "       %s changes [FROM_SEQ [follow]]\n"
+            "                          print the customer change feed from FROM_SEQ on\n"
+            "       %s serve [SOCKET [PORT]]\n"
+            "                          answer teller requests on SOCKET (default %s) and 127.0.0.1:PORT\n"
+            "       %s loadgen [SOCKET|PORT [CLIENTS [REQUESTS [WRITE_PERCENT]]]]\n"
+            "                          measure requests per second against a running server\n",
+            prog, prog, EMP_FILE, CUST_FILE, EMP_BIN, CUST_BIN, prog, prog, EMP_COL, CUST_COL, prog, prog,
+            prog, prog, prog,
+            prog, EMP_FILE, CUST_FILE, prog, prog, IMPORT_EMP_COLUMNS, IMPORT_CUST_COLUMNS, prog, prog,
+            CUST_FILE, prog, SHARD_SPLIT_ROWS, prog, prog, SERVER_SOCKET, prog);
+}
+
+static int run_command(int argc, char **argv) {
+    if (strcmp(argv[1], "convert") == 0 && argc == 3) {
+        if (strcmp(argv[2], "to-bin") == 0) return convert_to_binary();
+        if (strcmp(argv[2], "to-text") == 0) return convert_to_text();
+        if (strcmp(argv[2], "to-col") == 0) return convert_to_columnar();
+        if (strcmp(argv[2], "from-col") == 0) return convert_from_columnar();
     }
-    int found = 0;
-    for (int i = 0; i < count; ++i) {
-        if (custs[i].account == acc) {
-            found = 1;
-            printf("\n\tAccount: %d  Name: %s\n", custs[i].account, custs[i].name);
-            printf("\n\tAvailable balance: %ld\n", custs[i].balance);
-            printf("\n\tNote: deposit min 1000, max 50000\n");
-            
-            read_line_input("\n\tEnter amount to deposit: ", buf, sizeof(buf));
-            if (!is_numeric(buf)) {
-                printf("\n\tInvalid amount\n");
-                break;
-            }
-            long amount = atol(buf);
-            if (amount < 1000 || amount > 50000) { 
-                printf("\n\tInvalid amount.\n"); 
-                break; 
-            }
-            
-            read_line_input("\n\tConfirm deposit (YES/NO): ", buf, sizeof(buf));
-            if (strcasecmp(buf, "YES") == 0) {
-                custs[i].balance += amount;
-                save_customers(custs, count);
-                printf("\n\tDeposited. New balance: %ld\n", custs[i].balance);
-            } else {
-                printf("\n\tCancelled.\n");
-            }
-            break;
+    if (strcmp(argv[1], "batch") == 0 && (argc == 3 || argc == 4))
+        return run_batch(argv[2], argc == 4 ? argv[3] : NULL);
+    if (strcmp(argv[1], "stress") == 0 && argc <= 5) {
+        int threads = argc > 2 ? atoi(argv[2]) : online_cpus();
+        long ntx = argc > 3 ? atol(argv[3]) : 1000000;
+        int accounts = argc > 4 ? atoi(argv[4]) : 10000;
+        if (threads > 0 && ntx > 0 && accounts > 0) return run_stress(threads, ntx, accounts);
+    }
+    if (strcmp(argv[1], "bench-parse") == 0 && argc <= 3)
+        return run_bench_parse(argc == 3 ? argv[2] : CUST_FILE);
+    if (strcmp(argv[1], "generate") == 0 && argc >= 3 && argc <= 5) {
+        int ncust = atoi(argv[2]);
+        int nemp = argc > 3 ? atoi(argv[3]) : ncust / 10;
+        uint32_t seed = argc > 4 ? (uint32_t)strtoul(argv[4], NULL, 10) : 2463534242U;
+        if (ncust >= 0 && nemp >= 0) return run_generate(ncust, nemp, seed);
+    }
+    if (strcmp(argv[1], "bench") == 0) {
+        int sizes[16] = { 10000, 100000, 1000000 }, n = argc > 2 ? 0 : 3;
+        while (n < 16 && 2 + n < argc && atoi(argv[2 + n]) > 0) {
+            sizes[n] = atoi(argv[2 + n]);
+            n++;
         }
+        if (2 + n >= argc) return run_bench(sizes, n, 2463534242U);
+    }
+    if (strcmp(argv[1], "import") == 0 && (argc == 4 || argc == 5) &&
+        (strcmp(argv[2], "employees") == 0 || strcmp(argv[2], "customers") == 0))
+        return run_import(argv[2][0] == 'e', argv[3], argc == 5 ? argv[4] : NULL);
+    if (strcmp(argv[1], "export") == 0 && (argc == 5 || argc == 6) &&
+        (strcmp(argv[2], "employees") == 0 || strcmp(argv[2], "customers") == 0))
+        return run_export(argv[2][0] == 'e', argv[3], argv[4], argc == 6 ? argv[5] : NULL);
+    if (strcmp(argv[1], "colscan") == 0 && argc == 6 &&
+        (strcmp(argv[2], "employees") == 0 || strcmp(argv[2], "customers") == 0))
+        return run_colscan(argv[2][0] == 'e', argv[3], atoll(argv[4]), atoll(argv[5]));
+    if (strcmp(argv[1], "shard") == 0 && argc == 3 && atoi(argv[2]) >= 1 && atoi(argv[2]) <= SHARD_MAX)
+        return run_shard(atoi(argv[2]), 0);
+    if (strcmp(argv[1], "rebalance") == 0 && argc <= 3) {
+        int max_rows = argc == 3 ? atoi(argv[2]) : SHARD_SPLIT_ROWS;
+        if (max_rows > 0) return run_shard(0, max_rows);
     }
-    if (!found) printf("\n\tAccount not found\n");
-    free(custs);
+    if (strcmp(argv[1], "changes") == 0 && argc <= 4 && (argc < 4 || strcmp(argv[3], "follow") == 0))
+        return run_changes(argc > 2 ? strtoull(argv[2], NULL, 10) : 1, argc == 4);
+    if (strcmp(argv[1], "serve") == 0 && argc <= 4) {
+        int port = argc > 3 ? atoi(argv[3]) : 0;
+        if (port >= 0 && port <= 65535) return run_serve(argc > 2 ? argv[2] : SERVER_SOCKET, port);
+    }
+    if (strcmp(argv[1], "loadgen") == 0 && argc <= 6) {
+        int clients = argc > 3 ? atoi(argv[3]) : 8;
+        int requests = argc > 4 ? atoi(argv[4]) : 100000;
+        int write_percent = argc > 5 ? atoi(argv[5]) : 20;
+        if (clients > 0 && requests >= clients && write_percent >= 0 && write_percent <= 100)
+            return run_loadgen(argc > 2 ? argv[2] : SERVER_SOCKET, clients, requests, write_percent);
+    }
+    usage(argv[0]);
+    return 2;
 }
 
 /* ============================================================================
    MAIN MENU
    ============================================================================ */
 
-int main(void) {
+int main(int argc, char **argv) {
+    if (metrics_start_signal_thread() != 0) fprintf(stderr, "Statistics on SIGUSR1 unavailable\n");
+    if (argc > 1) return run_command(argc, argv);
+    if (store_load() != 0) {
+        fprintf(stderr, "Unable to load data files\n");
+        return 1;
+    }
     while (1) {
         printf("\n\t----------------------BANKING MANAGEMENT SYSTEM----------------------\n");
-        printf("\n\t\t1.CREATE NEW\n\t\t2.SEARCH DATA\n\t\t3.DELETE DATA\n\t\t4.UPDATE DATA\n\t\t5.VIEW ALL DATA\n\t\t6.CREATE EXPORT FILE\n\t\t7.WITHDRAWAL AMOUNT\n\t\t8.DEPOSIT AMOUNT\n\t\t9.EXIT PROGRAM\n");
+        printf("\n\t\t1.CREATE NEW\n\t\t2.SEARCH DATA\n\t\t3.DELETE DATA\n\t\t4.UPDATE DATA\n\t\t5.VIEW ALL DATA\n\t\t6.CREATE EXPORT FILE\n\t\t7.WITHDRAWAL AMOUNT\n\t\t8.DEPOSIT AMOUNT\n\t\t9.EXIT PROGRAM\n\t\t10.STATISTICS\n");
         char buf[16];
         printf("\n\t\tENTER YOUR CHOICE:  ");
         if (fgets(buf, sizeof(buf), stdin) == NULL) break;
         int ch = atoi(buf);
+        uint64_t t0 = metric_now();
+        metric_input_ns = 0;
         switch (ch) {
             case 1: create_new(); break;
             case 2: search_data(); break;
@@ -1030,13 +8072,23 @@ int main(void) {
             case 8: deposit_amount(); break;
             case 9:
                 printf("\n\t\tTHANKS FOR USING OUR APPLICATION\n");
+                store_flush();
+                store_free();
                 exit(0);
                 break;
+            case 10:
+                if (metrics_dump(stdout, STATS_FILE) == 0) printf("\n\tAlso written to %s\n", STATS_FILE);
+                else printf("\n\tUnable to write %s\n", STATS_FILE);
+                break;
             default:
                 printf("\n\t\tINVALID CHOICE ENTERED\n");
                 break;
         }
+        /* Menu entries 1-8 map onto M_MENU_CREATE.. in order */
+        if (ch >= 1 && ch <= 8) metric_record_ns(M_MENU_CREATE + ch - 1, metric_now() - t0 - metric_input_ns, 0, 0);
         printf("\n\t----------------------------------------------------------------------\n");
     }
+    store_flush();
+    store_free();
     return 0;
 }
\ No newline at end of file